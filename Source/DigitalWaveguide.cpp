@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    DigitalWaveguide.cpp
+    Created: 19 Oct 2026 11:04:17am
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "DigitalWaveguide.h"
+
+DigitalWaveguide::DigitalWaveguide (NamedValueSet& parameters, double k) : k (k),
+c (*parameters.getVarPointer("c")),
+L (*parameters.getVarPointer("L"))
+{
+    cToUse = c;
+    delay = L / (c * k);
+    
+    // the same range of c as the grid (a longer delay is clamped)
+    int maxDelay = Global::maxN * std::max (1.0, Global::gridScaling);
+    if (delay > maxDelay)
+    {
+        std::cout << "Choose a higher c or lower L" << std::endl;
+    }
+    
+    int size = nextPowerOfTwo (maxDelay + 4);
+    mask = size - 1;
+    upperRail.resize (size, 0);
+    lowerRail.resize (size, 0);
+    rightGoing.resize (size, 0);
+    leftGoing.resize (size, 0);
+    
+    excite();
+}
+
+void DigitalWaveguide::calculate()
+{
+    delay = L / (c * k);
+    
+    // Waves arriving at the boundaries after travelling the length of the string. The fractional part of the delay is a
+    // first-order Thiran allpass (Lagrange interpolation in the loop would damp the string at every round trip). Its
+    // previous output is the sample that was reflected into the other rail, so it doesn't need any state of its own.
+    const int delayInt = jlimit (1, mask - 2, static_cast<int> (floor (delay - 0.5)));
+    const double d = jlimit (0.5, 1.5, delay - delayInt); // 1 for integer N, which makes the allpass a delay of one sample
+    const double a = (1.0 - d) / (1.0 + d);
+    
+    const double upperPrevOut = -lowerRail[(writeIdx - 1) & mask];
+    const double lowerPrevOut = -upperRail[(writeIdx - 1) & mask];
+    double upperOut = a * upperRail[(writeIdx - delayInt) & mask] + upperRail[(writeIdx - delayInt - 1) & mask] - a * upperPrevOut;
+    double lowerOut = a * lowerRail[(writeIdx - delayInt) & mask] + lowerRail[(writeIdx - delayInt - 1) & mask] - a * lowerPrevOut;
+    
+    // inverting reflections
+    upperRail[writeIdx] = -lowerOut;
+    lowerRail[writeIdx] = -upperOut;
+}
+
+void DigitalWaveguide::updateStates()
+{
+    writeIdx = (writeIdx + 1) & mask;
+}
+
+double DigitalWaveguide::getOutput (double ratio)
+{
+    // the last written sample is 1 sample ago
+    return getDisplacement (ratio * delay, 1);
+}
+
+double DigitalWaveguide::getEnergy()
+{
+    // the same discrete energy as the grid with h = c * k (where h / k^2 = c^2 / h = c / k), at the current and the previous state
+    const int numPoints = static_cast<int> (ceil (delay)) - 1; // the points in between the boundaries
+    double kinEnergy = 0, potEnergy = 0;
+    double curPrev = 0, prevPrev = 0; // the boundary
+    for (int p = 1; p <= numPoints; ++p)
+    {
+        const double cur = getDisplacement (p, 1);
+        const double prev = getDisplacement (p, 2);
+        kinEnergy += (cur - prev) * (cur - prev);
+        potEnergy += (cur - curPrev) * (prev - prevPrev);
+        curPrev = cur;
+        prevPrev = prev;
+    }
+    
+    // the last interval ends at the other boundary
+    potEnergy += curPrev * prevPrev;
+    
+    return c / (2.0 * k) * (kinEnergy + potEnergy);
+}
+
+double DigitalWaveguide::readRail (const std::vector<double>& rail, double delayToRead)
+{
+    // all four samples need to have been written already
+    delayToRead = jlimit (2.0, static_cast<double> (mask - 2), delayToRead);
+    
+    int delayInt = floor (delayToRead);
+    double alf = delayToRead - delayInt;
+    
+    // samples at delayInt - 1, delayInt, delayInt + 1 and delayInt + 2
+    int idx = writeIdx - delayInt;
+    double sM1 = rail[(idx + 1) & mask];
+    double s0 = rail[idx & mask];
+    double s1 = rail[(idx - 1) & mask];
+    double s2 = rail[(idx - 2) & mask];
+    
+    return sM1 * (-alf * (alf - 1.0) * (alf - 2.0) / 6.0)
+        + s0 * ((alf + 1.0) * (alf - 1.0) * (alf - 2.0) * 0.5)
+        + s1 * (-(alf + 1.0) * alf * (alf - 2.0) * 0.5)
+        + s2 * ((alf + 1.0) * alf * (alf - 1.0) / 6.0);
+}
+
+void DigitalWaveguide::excite()
+{
+    // Same excitation as Dynamic1DWave::excite() (in grid points): f is added to the current and the previous state.
+    double N = delay;
+    double width = floor (0.1 * ceil (N * 0.5));
+    double start = floor (0.2 * N - width * 0.5);
+    if (width <= 0)
+        return;
+    
+    auto excitation = [&] (int pos) {
+        return (pos >= start && pos < start + width) ? 0.5 * (1 - cos (2.0 * double_Pi * (pos - start) / width)) : 0.0;
+    };
+    
+    // With a right-going wave a and a left-going wave b, the current state is f_p = a_p + b_p and the previous one
+    // f_p = a_{p+1} + b_{p-1}. This gives a_{p+1} = a_{p-1} + f_p - f_{p-1} (with a = 0 left of the excitation) and b_p = f_p - a_p.
+    const int numPoints = std::min (static_cast<int> (ceil (N)) + 3, mask);
+    rightGoing[0] = 0;
+    rightGoing[1] = 0;
+    for (int p = 1; p + 1 < numPoints; ++p)
+        rightGoing[p + 1] = rightGoing[p - 1] + excitation (p) - excitation (p - 1);
+    for (int p = 0; p < numPoints; ++p)
+        leftGoing[p] = excitation (p) - rightGoing[p];
+    
+    // note the addition here
+    for (int d = 1; d < numPoints; ++d)
+    {
+        upperRail[(writeIdx - d) & mask] += rightGoing[d - 1];
+        
+        // the points of the lower rail lie in between those of the grid if N is fractional
+        double pos = N + 1.0 - d;
+        int posInt = static_cast<int> (floor (pos));
+        double alf = pos - posInt;
+        if (posInt >= 0 && posInt + 1 < numPoints)
+            lowerRail[(writeIdx - d) & mask] += (1.0 - alf) * leftGoing[posInt] + alf * leftGoing[posInt + 1];
+    }
+}
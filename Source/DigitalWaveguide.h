@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    DigitalWaveguide.h
+    Created: 19 Oct 2026 11:04:17am
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Global.h"
+#include "VibratingString.h"
+
+//==============================================================================
+/*
+    Lossless string as two travelling waves (the upper rail moving right, the
+    lower rail moving left) with inverting reflections at both boundaries. Each
+    rail is a delay line of L / (c * k) samples whose fractional part is a
+    first-order Thiran allpass, so the length follows c continuously without
+    damping the string and every sample costs O(1) instead of O(N). The output
+    and the energy read the rails with third-order Lagrange interpolation (this
+    isn't part of the loop). Position p (in grid points of h = c * k)
+    of the upper rail is 1 + p samples ago, of the lower rail 1 + (N - p).
+    For an integer N (and a static c) it is exactly the grid of Dynamic1DWave
+    with gridScaling 1. Point forces don't fit the rails, so the resonator
+    mode and connections are only available on the grid.
+*/
+class DigitalWaveguide : public VibratingString
+{
+public:
+    DigitalWaveguide (NamedValueSet& parameters, double k);
+    
+    void calculate() override;
+    void updateStates() override;
+    
+    double getOutput (double ratio) override; // displacement at ratio * L
+    
+    void excite() override; // same raised cosine (and initial velocity) as Dynamic1DWave::excite()
+    
+    void changeWavespeed (double val) override { cToUse = val; }; // c is only used once per sample (before everything else)
+    void updateParams() override { c = cToUse; };
+    double getWavespeed() override { return c; };
+    double getLength() override { return L; };
+    double getDelay() { return delay; };
+    
+    double getEnergy() override; // energy of the displacement at the points of the grid (the same as Dynamic1DWave::getEnergy() for integer N)
+    
+private:
+    // value of the rail (delay) samples ago, 0 being the sample that is written in the current calculate() (Lagrange interpolated)
+    double readRail (const std::vector<double>& rail, double delayToRead);
+    double getDisplacement (double pos, int age) { return readRail (upperRail, age + pos) + readRail (lowerRail, age + delay - pos); }; // age 1 is the current state
+    
+    double k, c, cToUse, L;
+    double delay; // length of one rail in samples (L / (c * k))
+    
+    std::vector<double> upperRail, lowerRail;
+    std::vector<double> rightGoing, leftGoing; // scratch space for excite()
+    int writeIdx = 0;
+    int mask;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DigitalWaveguide)
+};
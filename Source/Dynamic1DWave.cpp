@@ -14,17 +14,23 @@
 //==============================================================================
 Dynamic1DWave::Dynamic1DWave (NamedValueSet& parameters, double k) : k (k),
 c (*parameters.getVarPointer("c")),
-L (*parameters.getVarPointer("L"))
+L (*parameters.getVarPointer("L")),
+gridScaling (parameters.getWithDefault ("gridScaling", 1.0))
 
 {
     cToUse = c;
+    cStatic = c;
     
-    h = c * k;
+    h = gridScaling * c * k;
     
     N = L/h;
     if (N > Global::maxN)
     {
-        std::cout << "Choose a higher c or lower L" << std::endl;
+        std::cout << "Choose a higher c, lower L or higher gridScaling" << std::endl;
+    }
+    if (gridScaling < 1.0)
+    {
+        std::cout << "A gridScaling below 1 needs theta >= 0.25" << std::endl;
     }
     
     
@@ -36,36 +42,35 @@ L (*parameters.getVarPointer("L"))
     
     lambdaSq = c * c * k * k / (h * h);
     
-    M = ceil (N * 0.5);
-    Mw = floor (N * 0.5);
+    M = ceil (Nint * 0.5);
+    Mw = floor (Nint * 0.5);
 
-    uStates.reserve (3);
-    wStates.reserve (3);
-    
-    for (int n = 0; n < 3; ++n) // include the boundaries
-    {
-        uStates.push_back (std::vector<double> (ceil (Global::maxN * 0.5) + 1, 0));
-        wStates.push_back (std::vector<double> (floor (Global::maxN * 0.5) + 1, 0));
-    }
+    // include the boundaries
+    uSize = ceil (Global::maxN * 0.5) + 1;
+    wSize = floor (Global::maxN * 0.5) + 1;
+    stateBuffer.resize (3 * (uSize + wSize), 0);
     
     u.reserve (3);
+    w.reserve (3);
     
     for (int n = 0; n < 3; ++n)
     {
-        u.push_back (&uStates[n][0]);
-        w.push_back (&wStates[n][0]);
+        u.push_back (&stateBuffer[n * uSize]);
+        w.push_back (&stateBuffer[3 * uSize + n * wSize]);
     }
     
+    // two time levels of all unknowns (the eigendecomposition itself is only allocated when modal synthesis is used)
+    modalState.resize (2 * (uSize + wSize), 0);
+    displayState.resize (2 * (uSize + wSize), 0);
+    modalGrid.resize (2 * (uSize + wSize), 0);
+    modalSavedState.resize (stateBuffer.size(), 0);
+    
+    implicitBand.resize (5 * (uSize + wSize), 0);
+    implicitRhs.resize (uSize + wSize, 0);
+    
     quadIp.resize (3);
     customIp.resize (4);
     excite();
-    
-    uState.open ("uState.csv");
-    wState.open ("wState.csv");
-    alfSave.open ("alfSave.csv");
-    MSave.open ("MSave.csv");
-    MwSave.open ("MwSave.csv");
-
 }
 
 Dynamic1DWave::~Dynamic1DWave()
@@ -84,53 +89,137 @@ void Dynamic1DWave::paint (juce::Graphics& g)
 
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));   // clear the background
 
-    g.setColour (Colours::cyan);
-    double visualScaling = 500;
-    Path stringPath = visualiseState (visualScaling, g);
-    g.strokePath (stringPath, PathStrokeType(2.0f));
+    // the images are rendered by updateVisualisation()
+    if (stateImage.isValid())
+        g.drawImageAt (stateImage, stringArea.getX(), stringArea.getY());
     
+    if (showWaterfall && waterfallImage.isValid() && waterfallArea.getHeight() > 0)
+        drawWaterfall (g, waterfallArea);
 }
 
-Path Dynamic1DWave::visualiseState (double visualScaling, Graphics& g)
+void Dynamic1DWave::updateVisualisation()
 {
-    auto stringBounds = getHeight() / 2.0;
-    Path stringPath;
-    stringPath.startNewSubPath (0, stringBounds);
-    int stateWidth = getWidth();
-    auto spacing = stateWidth / static_cast<double>(N + 1);
-    double x = 0;
+    if (stringArea.getWidth() <= 0 || stringArea.getHeight() <= 0)
+        return;
     
-    float newY;
-    bool switchToW = false;
-    for (int y = 0; y <= Nint+1; y++) // +1 for overlapping point
+    // (re)allocate only when the size changes
+    if (stateImage.getWidth() != stringArea.getWidth() || stateImage.getHeight() != stringArea.getHeight())
     {
-        if (y <= M)
-        {
-            newY = -u[1][y] * visualScaling + stringBounds; // Needs to be -u, because a positive u would visually go down
+        stateImage = Image (Image::ARGB, stringArea.getWidth(), stringArea.getHeight(), true);
+        columnMin.resize (stringArea.getWidth());
+        columnMax.resize (stringArea.getWidth());
+    }
+    
+    visualiseState (visualScaling, stringArea.getHeight());
+    
+    // draw the envelope of every pixel column into the image
+    stateImage.clear (stateImage.getBounds());
+    {
+        Graphics imageGraphics (stateImage);
+        imageGraphics.setColour (Colours::cyan);
+        for (int x = 0; x < stateImage.getWidth(); ++x)
+            imageGraphics.fillRect (x, static_cast<int> (columnMin[x]) - 1, 1, static_cast<int> (columnMax[x] - columnMin[x]) + 2); // 2 px thick
+    }
+    
+    if (showWaterfall && waterfallArea.getHeight() > 0)
+        addWaterfallRow();
+    
+    repaint();
+}
 
-        } else {
-            if (!switchToW)
-            {
-                x -= spacing;
-                x += alf * spacing;
-                switchToW = true;
-            }
-            newY = -w[1][y - M - 1] * visualScaling + stringBounds; // Needs to be -u, because a positive u would visually go down
-            
-        }
-        if (isnan(x) || isinf(abs(x) || isnan(newY) || isinf(abs(newY))))
-        {
-            std::cout << "Wait" << std::endl;
-        };
-        
-        if (isnan(newY))
+void Dynamic1DWave::visualiseState (double visualScaling, int height)
+{
+    // Decimates the state to pixel columns: every column gets the minimum and maximum
+    // of the (linearly interpolated) string inside it. The cost is O(N + width).
+    double stringBounds = height / 2.0;
+    int stateWidth = static_cast<int> (columnMin.size());
+    double spacing = stateWidth / (getGridLength() / h);
+    
+    std::fill (columnMin.begin(), columnMin.end(), std::numeric_limits<float>::max());
+    std::fill (columnMax.begin(), columnMax.end(), std::numeric_limits<float>::lowest());
+    
+    // the modal state is reconstructed into a buffer of its own, the audio thread doesn't use it
+    bool showModes = modalActive;
+    if (showModes)
+        modalEngine.reconstruct (displayState.data());
+    
+    auto getY = [&] (int idx) {
+        int row = getStateRow (idx);
+        double val = showModes ? (row < 0 ? 0.0 : displayState[row]) : getState (idx, 1);
+        double newY = -val * visualScaling + stringBounds; // Needs to be -u, because a positive u would visually go down
+        if (isnan (newY))
             newY = 0;
-        stringPath.lineTo(x, newY);
-        x += spacing;
+        return static_cast<float> (jlimit (0.0, static_cast<double> (height - 1), newY));
+    };
+    
+    double xPrev = 0;
+    float yPrev = getY (0);
+    for (int idx = 1; idx <= M + Mw + 1; ++idx)
+    {
+        double xCur = getGridPosition (idx) / h * spacing;
+        float yCur = getY (idx);
         
+        // all columns this segment passes through
+        int firstColumn = jlimit (0, stateWidth - 1, static_cast<int> (xPrev));
+        int lastColumn = jlimit (0, stateWidth - 1, static_cast<int> (xCur));
+        for (int col = firstColumn; col <= lastColumn; ++col)
+        {
+            // the segment clipped to this column
+            double x0 = std::max (xPrev, static_cast<double> (col));
+            double x1 = std::min (xCur, col + 1.0);
+            float y0 = xCur > xPrev ? yPrev + (yCur - yPrev) * (x0 - xPrev) / (xCur - xPrev) : yPrev;
+            float y1 = xCur > xPrev ? yPrev + (yCur - yPrev) * (x1 - xPrev) / (xCur - xPrev) : yCur;
+            columnMin[col] = std::min (columnMin[col], std::min (y0, y1));
+            columnMax[col] = std::max (columnMax[col], std::max (y0, y1));
+        }
+        xPrev = xCur;
+        yPrev = yCur;
+    }
+    
+    // columns that no segment has reached (rounding at the right end)
+    for (int col = 0; col < stateWidth; ++col)
+    {
+        if (columnMin[col] > columnMax[col])
+        {
+            columnMin[col] = stringBounds;
+            columnMax[col] = stringBounds;
+        }
     }
-    stringPath.lineTo (stateWidth, stringBounds);
-    return stringPath;
+}
+
+void Dynamic1DWave::addWaterfallRow()
+{
+    if (waterfallImage.getWidth() != waterfallArea.getWidth() || waterfallImage.getHeight() != waterfallArea.getHeight())
+    {
+        waterfallImage = Image (Image::RGB, waterfallArea.getWidth(), waterfallArea.getHeight(), true);
+        waterfallRow = waterfallImage.getHeight() - 1;
+    }
+    
+    // overwrite the oldest row with the newest (only this row changes)
+    waterfallRow = (waterfallRow + 1) % waterfallImage.getHeight();
+    double centre = stateImage.getHeight() * 0.5;
+    int width = std::min (waterfallImage.getWidth(), static_cast<int> (columnMin.size()));
+    {
+        Image::BitmapData rowData (waterfallImage, 0, waterfallRow, waterfallImage.getWidth(), 1, Image::BitmapData::writeOnly);
+        for (int x = 0; x < width; ++x)
+        {
+            // columnMin / columnMax are in pixels, so this is the displacement relative to the visible range
+            float val = static_cast<float> (jlimit (-1.0, 1.0, (centre - (columnMin[x] + columnMax[x]) * 0.5) / centre));
+            rowData.setPixelColour (x, 0, val > 0 ? Colours::black.interpolatedWith (Colours::cyan, val)
+                                                  : Colours::black.interpolatedWith (Colours::orange, -val));
+        }
+    }
+}
+
+void Dynamic1DWave::drawWaterfall (Graphics& g, Rectangle<int> area)
+{
+    // oldest row at the top and the newest at the bottom, so the image scrolls up
+    int numRows = waterfallImage.getHeight();
+    int olderRows = numRows - waterfallRow - 1;
+    g.drawImage (waterfallImage, area.getX(), area.getY(), area.getWidth(), olderRows,
+                 0, waterfallRow + 1, waterfallImage.getWidth(), olderRows);
+    g.drawImage (waterfallImage, area.getX(), area.getY() + olderRows, area.getWidth(), waterfallRow + 1,
+                 0, 0, waterfallImage.getWidth(), waterfallRow + 1);
 }
 
 void Dynamic1DWave::resized()
@@ -138,20 +227,98 @@ void Dynamic1DWave::resized()
     // This method is where you should set the bounds of any child
     // components that your component contains..
 
+    stringArea = getLocalBounds();
+    waterfallArea = showWaterfall ? stringArea.removeFromBottom (getHeight() / 3) : Rectangle<int>();
 }
 
 void Dynamic1DWave::calculate()
 {
-    recalculateCoeffs();
+    if (modalSynthesis)
+    {
+        if (c == cStatic)
+        {
+            ++staticCount;
+        }
+        else
+        {
+            cStatic = c;
+            staticCount = 0;
+            ++modalId;
+        }
+        
+        if (modalActive)
+        {
+            if (staticCount > 0)
+            {
+                modalEngine.calculate();
+                if (idleDetection && staticCount % modalIdleInterval == 0)
+                    checkModalIdle();
+                return;
+            }
+            switchToGrid(); // a sweep has started (this needs the grid from before the change in c)
+        }
+        else if (!sleeping && (!idleDetection || energyEstimate >= idleThreshold)
+                 && (modalSwitchRequested || (automaticModalSwitch && staticCount >= modalHoldSamples)))
+        {
+            if (switchToModal())
+            {
+                modalEngine.calculate();
+                return;
+            }
+        }
+    }
+    
+    recalculateCoeffs(); // keeps the grid up to date, also while sleeping
+    if (sleeping)
+        return;
+    
     calculateInterpolatedPoints();
-//    lowPassConnection();
+    if (useLowPassConnection)
+        lowPassConnection();
     calculateScheme();
-    displacementCorrection();
+    if (!externalJunctionCorrection)
+        displacementCorrection();
+    
+    if (idleDetection)
+        checkIdle();
+}
+
+void Dynamic1DWave::checkIdle()
+{
+    if (energyEstimate >= idleThreshold)
+    {
+        idleCount = 0;
+        return;
+    }
+    
+    if (++idleCount < idleHoldSamples)
+        return;
+    
+    // freeze: clear all time levels so that the string outputs zeros and can be excited from rest
+    std::fill (stateBuffer.begin(), stateBuffer.end(), 0);
+    sleeping = true;
+}
+
+void Dynamic1DWave::checkModalIdle()
+{
+    // every mode decays on its own, so their sum of squares follows the energy estimate (scaled to it at the switch)
+    energyEstimate = modalEnergyScale * modalEngine.getSumOfSquares();
+    if (energyEstimate >= idleThreshold)
+    {
+        idleCount = 0;
+        return;
+    }
+    
+    idleCount += modalIdleInterval;
+    if (idleCount < idleHoldSamples)
+        return;
+    
+    resetState(); // back to the grid, asleep
 }
 
 void Dynamic1DWave::recalculateCoeffs()
 {
-    h = c * k;
+    h = gridScaling * c * k;
     N = L / h;
     Nint = floor(N);
     lambdaSq = c * c * k * k / (h * h);
@@ -187,10 +354,7 @@ void Dynamic1DWave::lowPassConnection()
 
 void Dynamic1DWave::displacementCorrection()
 {
-    double etaDiv = 1.0;
-    double epsilon = 0;
     double etaPrev = (w[2][0] - u[2][M]) * etaDiv;
-    double sig0 = 1.0;
     
     double rForce = (1.0 - sig0 / k) / (1.0 + sig0 / k);
     double oOP = (h * (1.0 + sig0 / k) * (1.0 - alf)) / (2.0 * h * (alf + epsilon) + 2.0 * etaDiv * k * k * (1.0 + sig0 / k) * (1.0 - alf));
@@ -201,28 +365,247 @@ void Dynamic1DWave::displacementCorrection()
     w[0][0] -= k*k/h * F;
 }
 
+bool Dynamic1DWave::setTheta (double thetaToSet)
+{
+    if (!isStableTheta (thetaToSet, gridScaling, true))
+        return false;
+    
+    theta = thetaToSet;
+    invalidateModes();
+    return true;
+}
+
+bool Dynamic1DWave::isStableTheta (double theta, double gridScaling, bool printReason)
+{
+    // lambdaSq = 1 / gridScaling^2 does not change with c
+    const double lambdaSq = 1.0 / (gridScaling * gridScaling);
+    if (theta < 0.25 && lambdaSq * (1.0 - 4.0 * theta) > 1.0)
+    {
+        if (printReason)
+            std::cout << "Unstable combination of theta and gridScaling" << std::endl;
+        return false;
+    }
+    if (theta < 0 && -theta * lambdaSq > 1.0 / 12.0)
+    {
+        if (printReason)
+            std::cout << "Theta is too negative for the solver" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 void Dynamic1DWave::calculateScheme()
 {
+    if (theta != 0)
+    {
+        calculateImplicitScheme();
+        return;
+    }
+    
     // calculate interpolated points
     
     // calculate u
-    for (int l = 1; l < M; ++l)
-        u[0][l] = 2 * u[1][l] - u[2][l] + lambdaSq * (u[1][l+1] - 2 * u[1][l] + u[1][l-1]);
-    
-    // calculate w
-    for (int l = 1; l < Mw; ++l)
-        w[0][l] = 2 * w[1][l] - w[2][l] + lambdaSq * (w[1][l+1] - 2 * w[1][l] + w[1][l-1]);
+    if (idleDetection)
+    {
+        // same as below, but also accumulates the energy estimate
+        double velSq = 0;
+        double slopeSq = 0;
+        for (int l = 1; l < M; ++l)
+        {
+            u[0][l] = 2 * u[1][l] - u[2][l] + lambdaSq * (u[1][l+1] - 2 * u[1][l] + u[1][l-1]);
+            velSq += (u[0][l] - u[1][l]) * (u[0][l] - u[1][l]);
+            slopeSq += (u[1][l] - u[1][l-1]) * (u[1][l] - u[1][l-1]);
+        }
+        for (int l = 1; l < Mw; ++l)
+        {
+            w[0][l] = 2 * w[1][l] - w[2][l] + lambdaSq * (w[1][l+1] - 2 * w[1][l] + w[1][l-1]);
+            velSq += (w[0][l] - w[1][l]) * (w[0][l] - w[1][l]);
+            slopeSq += (w[1][l+1] - w[1][l]) * (w[1][l+1] - w[1][l]);
+        }
+        energyEstimate = velSq + lambdaSq * slopeSq;
+    }
+    else
+    {
+        for (int l = 1; l < M; ++l)
+            u[0][l] = 2 * u[1][l] - u[2][l] + lambdaSq * (u[1][l+1] - 2 * u[1][l] + u[1][l-1]);
+        
+        // calculate w
+        for (int l = 1; l < Mw; ++l)
+            w[0][l] = 2 * w[1][l] - w[2][l] + lambdaSq * (w[1][l+1] - 2 * w[1][l] + w[1][l-1]);
+    }
     
     // add interpolated points
     u[0][M] = 2 * u[1][M] - u[2][M] + lambdaSq * (uMp1 - 2 * u[1][M] + u[1][M-1]);
     
     w[0][0] = 2 * w[1][0] - w[2][0] + lambdaSq * (w[1][1] - 2 * w[1][0] + wm1);
+    
+    if (idleDetection)
+    {
+        // points around the connection
+        energyEstimate += (u[0][M] - u[1][M]) * (u[0][M] - u[1][M]) + (w[0][0] - w[1][0]) * (w[0][0] - w[1][0])
+            + lambdaSq * ((u[1][M] - u[1][M-1]) * (u[1][M] - u[1][M-1]) + (w[1][0] - u[1][M]) * (w[1][0] - u[1][M])
+                          + (w[1][1] - w[1][0]) * (w[1][1] - w[1][0]));
+    }
+
+}
+
 
+void Dynamic1DWave::factoriseImplicitScheme()
+{
+    // (I - theta * lambdaSq * D) u^{n+1} = 2u^n - u^{n-1} + (1 - 2 theta) * lambdaSq * D u^n + theta * lambdaSq * D u^{n-1}
+    // with D the second difference including the interpolated points. The unknowns are u_1, ..., u_M, w_0, ..., w_{Mw-1}
+    // (the outer boundaries are fixed at 0). The matrix is tridiagonal, apart from the rows of u_M and w_0 that also reach
+    // w_1 and u_{M-1} through the quadratic interpolation, so it is factorised as a banded system with two sub- and superdiagonals.
+    // It is diagonally dominant for theta >= 0 and for theta >= -1 / (12 * lambdaSq) so no pivoting is needed.
+    const int numUnknowns = M + Mw;
+    const double thetaLambdaSq = theta * lambdaSq;
+    double* band = implicitBand.data();
+    
+    double* row = band;
+    for (int l = 1; l < M; ++l)
+    {
+        row[0] = 0;
+        row[1] = -thetaLambdaSq;
+        row[2] = 1.0 + 2.0 * thetaLambdaSq;
+        row[3] = -thetaLambdaSq;
+        row[4] = 0;
+        row += 5;
+    }
+    
+    // u_M (columns u_{M-1}, u_M, w_0, w_1)
+    row[0] = 0;
+    row[1] = -thetaLambdaSq;
+    row[2] = 1.0 - thetaLambdaSq * (quadIp[2] - 2.0);
+    row[3] = -thetaLambdaSq * quadIp[1];
+    row[4] = -thetaLambdaSq * quadIp[0];
+    row += 5;
+    
+    // w_0 (columns u_{M-1}, u_M, w_0, w_1)
+    row[0] = -thetaLambdaSq * quadIp[0];
+    row[1] = -thetaLambdaSq * quadIp[1];
+    row[2] = 1.0 - thetaLambdaSq * (quadIp[2] - 2.0);
+    row[3] = -thetaLambdaSq;
+    row[4] = 0;
+    row += 5;
+    
+    for (int l = 1; l < Mw; ++l)
+    {
+        row[0] = 0;
+        row[1] = -thetaLambdaSq;
+        row[2] = 1.0 + 2.0 * thetaLambdaSq;
+        row[3] = -thetaLambdaSq;
+        row[4] = 0;
+        row += 5;
+    }
+    
+    // LU in place: the factors of the elimination replace the entries they eliminate (only the entries within the matrix are touched)
+    for (int i = 0; i < numUnknowns - 1; ++i)
+    {
+        const double* pivotRow = band + 5 * i;
+        const int lastRow = std::min (i + 2, numUnknowns - 1);
+        for (int r = i + 1; r <= lastRow; ++r)
+        {
+            double* curRow = band + 5 * r;
+            const double factor = curRow[i - r + 2] / pivotRow[2];
+            curRow[i - r + 2] = factor;
+            if (factor == 0)
+                continue;
+            
+            for (int col = i + 1; col <= lastRow; ++col)
+                curRow[col - r + 2] -= factor * pivotRow[col - i + 2];
+        }
+    }
+    
+    factorisedThetaLambdaSq = thetaLambdaSq;
+    factorisedM = M;
+    factorisedMw = Mw;
+    std::copy (quadIp.begin(), quadIp.end(), factorisedQuadIp);
 }
 
+void Dynamic1DWave::calculateImplicitScheme()
+{
+    // see factoriseImplicitScheme() for the system
+    const int numUnknowns = M + Mw;
+    const double thetaLambdaSq = theta * lambdaSq;
+    const double explicitLambdaSq = (1.0 - 2.0 * theta) * lambdaSq;
+    
+    // the matrix only changes with theta, lambdaSq, alf (through quadIp) and the number of points, so a static c only solves
+    if (thetaLambdaSq != factorisedThetaLambdaSq || M != factorisedM || Mw != factorisedMw
+        || !std::equal (quadIp.begin(), quadIp.end(), factorisedQuadIp))
+        factoriseImplicitScheme();
+    
+    const double* band = implicitBand.data();
+    double* rhs = implicitRhs.data();
+    
+    // interpolated points at the previous time step (those at the current one are calculated in calculateInterpolatedPoints())
+    double uMp1Prev = u[2][M] * quadIp[2]  + w[2][0] * quadIp[1] + w[2][1] * quadIp[0];
+    double wm1Prev = u[2][M-1] * quadIp[0] + u[2][M] * quadIp[1]  + w[2][0] * quadIp[2];
+    
+    // right hand side
+    for (int l = 1; l < M; ++l)
+        rhs[l-1] = 2 * u[1][l] - u[2][l] + explicitLambdaSq * (u[1][l+1] - 2 * u[1][l] + u[1][l-1])
+            + thetaLambdaSq * (u[2][l+1] - 2 * u[2][l] + u[2][l-1]);
+    rhs[M-1] = 2 * u[1][M] - u[2][M] + explicitLambdaSq * (uMp1 - 2 * u[1][M] + u[1][M-1])
+        + thetaLambdaSq * (uMp1Prev - 2 * u[2][M] + u[2][M-1]);
+    rhs[M] = 2 * w[1][0] - w[2][0] + explicitLambdaSq * (w[1][1] - 2 * w[1][0] + wm1)
+        + thetaLambdaSq * (w[2][1] - 2 * w[2][0] + wm1Prev);
+    for (int l = 1; l < Mw; ++l)
+        rhs[M+l] = 2 * w[1][l] - w[2][l] + explicitLambdaSq * (w[1][l+1] - 2 * w[1][l] + w[1][l-1])
+            + thetaLambdaSq * (w[2][l+1] - 2 * w[2][l] + w[2][l-1]);
+    
+    // forward substitution with the factors of the elimination (the first two entries of every row)
+    rhs[1] -= band[5 + 1] * rhs[0];
+    for (int r = 2; r < numUnknowns; ++r)
+    {
+        const double* curRow = band + 5 * r;
+        rhs[r] -= curRow[0] * rhs[r-2];
+        rhs[r] -= curRow[1] * rhs[r-1];
+    }
+    
+    // back substitution
+    for (int r = numUnknowns - 1; r >= 0; --r)
+    {
+        const double* curRow = band + 5 * r;
+        double sum = rhs[r];
+        if (r + 1 < numUnknowns)
+            sum -= curRow[3] * rhs[r+1];
+        if (r + 2 < numUnknowns)
+            sum -= curRow[4] * rhs[r+2];
+        rhs[r] = sum / curRow[2];
+    }
+    
+    for (int l = 1; l <= M; ++l)
+        u[0][l] = rhs[l-1];
+    for (int l = 0; l < Mw; ++l)
+        w[0][l] = rhs[M+l];
+    
+    if (idleDetection)
+    {
+        double velSq = 0;
+        double slopeSq = 0;
+        for (int l = 1; l <= M; ++l)
+        {
+            velSq += (u[0][l] - u[1][l]) * (u[0][l] - u[1][l]);
+            slopeSq += (u[1][l] - u[1][l-1]) * (u[1][l] - u[1][l-1]);
+        }
+        for (int l = 0; l < Mw; ++l)
+        {
+            velSq += (w[0][l] - w[1][l]) * (w[0][l] - w[1][l]);
+            slopeSq += (w[1][l+1] - w[1][l]) * (w[1][l+1] - w[1][l]);
+        }
+        slopeSq += (w[1][0] - u[1][M]) * (w[1][0] - u[1][M]);
+        energyEstimate = velSq + lambdaSq * slopeSq;
+    }
+}
 
 void Dynamic1DWave::updateStates()
 {
+    if (modalActive)
+    {
+        modalEngine.updateStates();
+        return;
+    }
+    
     double* uTmp = u[2];
     u[2] = u[1];
     u[1] = u[0];
@@ -322,6 +705,10 @@ void Dynamic1DWave::excite()
     int start = floor (loc-width*0.5);
     int end = std::min (M, static_cast<int>(start+width));
     
+    wake();
+    if (modalActive)
+        switchToGrid();
+    
     // note the addition here
     
     for (int l = start; l < end; ++l)
@@ -331,30 +718,191 @@ void Dynamic1DWave::excite()
     }
 }
 
+void Dynamic1DWave::getConnectionPoints (double ratio, int& idx, double& weight0, double& weight1)
+{
+    double pos = Nint * ratio;
+    idx = floor (pos);
+    double frac = pos - idx;
+    
+    int lastIdx = M + Mw + 1;
+    idx = jlimit (0, lastIdx - 1, idx);
+    
+    // u_M and w_0 are already connected to each other (and are not a
+    // regular part of the grid), so connect to their neighbours instead
+    if (idx == M - 1 || (idx == M && frac < 0.5))
+    {
+        idx = M - 1;
+        weight0 = 1;
+        weight1 = 0;
+    }
+    else if (idx == M || idx == M + 1)
+    {
+        idx = M + 1;
+        weight0 = 0;
+        weight1 = 1;
+    }
+    else
+    {
+        weight0 = 1.0 - frac;
+        weight1 = frac;
+    }
+    
+    // the boundaries are fixed
+    if (idx == 0)
+        weight0 = 0;
+    if (idx + 1 == lastIdx)
+        weight1 = 0;
+}
+
+void Dynamic1DWave::getJunctionCoefficients (double& invAlpha, double& betaOverAlpha)
+{
+    // displacementCorrection written as F = alpha * eta^{n+1} + beta * eta^{n-1} with eta = w_0 - u_M
+    invAlpha = 2.0 * (alf + epsilon) / (etaDiv * (1.0 + sig0 / k) * (1.0 - alf));
+    betaOverAlpha = (1.0 - sig0 / k) / (1.0 + sig0 / k);
+}
+
+double Dynamic1DWave::getStateAt (double ratio, int timeIdx)
+{
+    int idx;
+    double weight0, weight1;
+    getConnectionPoints (ratio, idx, weight0, weight1);
+    return weight0 * getState (idx, timeIdx) + weight1 * getState (idx + 1, timeIdx);
+}
+
+void Dynamic1DWave::addForceAt (double ratio, double force)
+{
+    jassert (!modalActive); // forces can only be applied to the grid
+    if (force == 0)
+        return;
+    
+    int idx;
+    double weight0, weight1;
+    getConnectionPoints (ratio, idx, weight0, weight1);
+    
+    getState (idx, 0) += k * k / h * force * weight0;
+    getState (idx + 1, 0) += k * k / h * force * weight1;
+    injectedEnergy += 0.5 * force * (weight0 * (getState (idx, 0) - getState (idx, 2))
+                                     + weight1 * (getState (idx + 1, 0) - getState (idx + 1, 2)));
+    
+    wake();
+}
+
+double Dynamic1DWave::getEnergy()
+{
+    if (modalActive)
+    {
+        // from the reconstructed grid (O(N * modes), too slow for every block on the audio thread)
+        double* uGrid = modalGrid.data();
+        double* wGrid = uGrid + 2 * uSize;
+        modalEngine.reconstruct (modalState.data());
+        scatterState (modalState.data(), uGrid, uGrid + uSize, wGrid, wGrid + wSize);
+        return calculateEnergy (uGrid, uGrid + uSize, wGrid, wGrid + wSize);
+    }
+    return calculateEnergy (u[1], u[2], w[1], w[2]);
+}
+
+double Dynamic1DWave::calculateEnergy (const double* u1, const double* u2, const double* w1, const double* w2)
+{
+    // kinetic energy
+    double kinEnergy = 0;
+    for (int l = 1; l <= M; ++l)
+        kinEnergy += (u1[l] - u2[l]) * (u1[l] - u2[l]);
+    for (int l = 0; l < Mw; ++l)
+        kinEnergy += (w1[l] - w2[l]) * (w1[l] - w2[l]);
+    kinEnergy *= h / (2.0 * k * k);
+    
+    // potential energy
+    double potEnergy = 0;
+    for (int l = 0; l < M; ++l)
+        potEnergy += (u1[l+1] - u1[l]) * (u2[l+1] - u2[l]);
+    for (int l = 0; l < Mw; ++l)
+        potEnergy += (w1[l+1] - w1[l]) * (w2[l+1] - w2[l]);
+    potEnergy *= c * c / (2.0 * h);
+    
+    return kinEnergy + potEnergy;
+}
+
+double Dynamic1DWave::getStateSumOfSquares()
+{
+    // the grid isn't updated while the modes are active
+    if (modalActive)
+        return modalEngine.getSumOfSquares();
+    
+    // four independent partial sums so that the loop can be vectorised without reordering a single sum
+    const double* states = stateBuffer.data();
+    const int size = static_cast<int> (stateBuffer.size());
+    double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+    
+    int i = 0;
+    for (; i + 3 < size; i += 4)
+    {
+        sum0 += states[i] * states[i];
+        sum1 += states[i + 1] * states[i + 1];
+        sum2 += states[i + 2] * states[i + 2];
+        sum3 += states[i + 3] * states[i + 3];
+    }
+    for (; i < size; ++i)
+        sum0 += states[i] * states[i];
+    
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+void Dynamic1DWave::resetState()
+{
+    std::fill (stateBuffer.begin(), stateBuffer.end(), 0);
+    modalActive = false;
+    staticCount = 0;
+    
+    if (idleDetection)
+    {
+        sleeping = true;
+        idleCount = 0;
+    }
+}
+
+void Dynamic1DWave::scaleState (double gain)
+{
+    if (modalActive)
+        switchToGrid();
+    
+    for (auto& state : stateBuffer)
+        state *= gain;
+}
+
 void Dynamic1DWave::saveToFiles()
 {
+    // only create the files when they are actually used
+    if (!uState.is_open())
+    {
+        uState.open ("uState.csv");
+        wState.open ("wState.csv");
+        alfSave.open ("alfSave.csv");
+        MSave.open ("MSave.csv");
+        MwSave.open ("MwSave.csv");
+    }
+    
     alfSave << alf << ";\n";
     MSave << M << ";\n";
     MwSave << Mw << ";\n";
     
-    for (int l = 0; l < uStates[0].size(); ++l)
+    for (int l = 0; l < uSize; ++l)
     {
         if (l <= M)
             uState << u[1][l];
         else
             uState << 0;
-        if (l != uStates[0].size()-1)
+        if (l != uSize-1)
             uState << ", ";
     }
     uState << ";\n";
 
-    for (int l = 0; l < wStates[0].size(); ++l)
+    for (int l = 0; l < wSize; ++l)
     {
         if (l <= Mw)
             wState << w[1][l];
         else
             wState << 0;
-        if (l != wStates[0].size()-1)
+        if (l != wSize-1)
             wState << ", ";
     }
     wState << ";\n";
@@ -369,3 +917,283 @@ void Dynamic1DWave::closeFiles()
     MwSave.close();
 
 }
+
+void Dynamic1DWave::saveCheckpoint (void* dest) const
+{
+    CheckpointHeader header;
+    memset (&header, 0, sizeof (CheckpointHeader)); // so that equal states give equal checkpoints (padding included)
+    header.magic = checkpointMagic;
+    header.version = checkpointVersion;
+    header.uSize = uSize;
+    header.wSize = wSize;
+    header.Nint = Nint;
+    header.NintPrev = NintPrev;
+    header.M = M;
+    header.Mw = Mw;
+    header.sleeping = sleeping;
+    header.idleCount = idleCount;
+    header.staticCount = staticCount;
+    header.idleDetection = idleDetection;
+    header.modalSynthesis = modalSynthesis;
+    header.externalJunctionCorrection = externalJunctionCorrection;
+    header.useLowPassConnection = useLowPassConnection;
+    
+    // the time levels get swapped every sample, so store where they currently point to
+    for (int n = 0; n < 3; ++n)
+    {
+        header.uIdx[n] = static_cast<int32> ((u[n] - stateBuffer.data()) / uSize);
+        header.wIdx[n] = static_cast<int32> ((w[n] - stateBuffer.data() - 3 * uSize) / wSize);
+    }
+    
+    header.k = k;
+    header.N = N;
+    header.c = c;
+    header.cToUse = cToUse;
+    header.lambdaSq = lambdaSq;
+    header.h = h;
+    header.L = L;
+    header.alf = alf;
+    header.alfTick = alfTick;
+    header.lpExponent = lpExponent;
+    header.sig0 = sig0;
+    header.etaDiv = etaDiv;
+    header.epsilon = epsilon;
+    header.theta = theta;
+    header.gridScaling = gridScaling;
+    header.energyEstimate = energyEstimate;
+    
+    char* destBytes = static_cast<char*> (dest);
+    memcpy (destBytes, &header, sizeof (CheckpointHeader));
+    char* destState = destBytes + sizeof (CheckpointHeader);
+    memcpy (destState, stateBuffer.data(), stateBuffer.size() * sizeof (double));
+    
+    // the grid isn't updated while the modes are, so write the state of the modes into the copy instead
+    if (modalActive)
+    {
+        const int numUnknowns = M + Mw;
+        for (int row = 0; row < 2 * numUnknowns; ++row)
+        {
+            const double value = modalEngine.evaluate (row);
+            const double* target = &getUnknown (row % numUnknowns, row < numUnknowns ? 1 : 2);
+            memcpy (destState + (target - stateBuffer.data()) * sizeof (double), &value, sizeof (double));
+        }
+    }
+}
+
+void Dynamic1DWave::saveCheckpoint (MemoryBlock& dest) const
+{
+    dest.ensureSize (getCheckpointSize());
+    saveCheckpoint (dest.getData());
+}
+
+bool Dynamic1DWave::restoreCheckpoint (const void* src, size_t size)
+{
+    if (size < getCheckpointSize())
+    {
+        std::cout << "Checkpoint is too small" << std::endl;
+        return false;
+    }
+    
+    CheckpointHeader header;
+    const char* srcBytes = static_cast<const char*> (src);
+    memcpy (&header, srcBytes, sizeof (CheckpointHeader));
+    
+    if (header.magic != checkpointMagic || header.version != checkpointVersion)
+    {
+        std::cout << "Not a valid checkpoint (or saved with a different version)" << std::endl;
+        return false;
+    }
+    
+    if (header.uSize != uSize || header.wSize != wSize)
+    {
+        std::cout << "Checkpoint was saved with a different Global::maxN" << std::endl;
+        return false;
+    }
+    
+    if (!isValidHeader (header, uSize, wSize))
+    {
+        std::cout << "Checkpoint is corrupt" << std::endl;
+        return false;
+    }
+    
+    memcpy (stateBuffer.data(), srcBytes + sizeof (CheckpointHeader), stateBuffer.size() * sizeof (double));
+    
+    for (int n = 0; n < 3; ++n)
+    {
+        u[n] = &stateBuffer[header.uIdx[n] * uSize];
+        w[n] = &stateBuffer[3 * uSize + header.wIdx[n] * wSize];
+    }
+    
+    Nint = header.Nint;
+    NintPrev = header.NintPrev;
+    M = header.M;
+    Mw = header.Mw;
+    sleeping = header.sleeping;
+    idleCount = header.idleCount;
+    idleDetection = header.idleDetection;
+    externalJunctionCorrection = header.externalJunctionCorrection;
+    useLowPassConnection = header.useLowPassConnection;
+    
+    k = header.k;
+    N = header.N;
+    c = header.c;
+    cToUse = header.cToUse;
+    lambdaSq = header.lambdaSq;
+    h = header.h;
+    L = header.L;
+    alf = header.alf;
+    alfTick = header.alfTick;
+    lpExponent = header.lpExponent;
+    sig0 = header.sig0;
+    etaDiv = header.etaDiv;
+    epsilon = header.epsilon;
+    theta = header.theta;
+    gridScaling = header.gridScaling;
+    energyEstimate = header.energyEstimate;
+    
+    // the modes (if any) are saved as the grid state, the string switches to modes again after the remaining static samples
+    modalSynthesis = header.modalSynthesis;
+    if (modalSynthesis)
+        modalEngine.prepare (2 * (uSize + wSize));
+    modalActive = false;
+    cStatic = c;
+    staticCount = header.staticCount;
+    ++modalId;
+    
+    return true;
+}
+
+bool Dynamic1DWave::isValidHeader (const CheckpointHeader& header, int uSize, int wSize)
+{
+    // the time levels have to point to different blocks of the state buffer
+    for (int n = 0; n < 3; ++n)
+    {
+        if (header.uIdx[n] < 0 || header.uIdx[n] > 2 || header.wIdx[n] < 0 || header.wIdx[n] > 2)
+            return false;
+        
+        for (int m = 0; m < n; ++m)
+            if (header.uIdx[n] == header.uIdx[m] || header.wIdx[n] == header.wIdx[m])
+                return false;
+    }
+    
+    // u and w share the points as addRemovePoint does and both fit in the state buffer (including the boundaries)
+    if (header.M + header.Mw != header.Nint || header.M - header.Mw < 0 || header.M - header.Mw > 1
+        || header.Mw < 1 || header.M >= uSize || header.Mw >= wSize
+        || std::abs (header.Nint - header.NintPrev) > 1)
+        return false;
+    
+    if (!(header.k > 0 && header.h > 0 && header.L > 0 && header.c > 0 && header.cToUse > 0)
+        || std::floor (header.N) != header.Nint || header.idleCount < 0 || header.staticCount < 0)
+        return false;
+    
+    return true;
+}
+
+void Dynamic1DWave::setModalSynthesis (bool useModalSynthesis)
+{
+    modalSynthesis = useModalSynthesis;
+    if (modalSynthesis)
+        modalEngine.prepare (2 * (uSize + wSize));
+    else if (modalActive)
+        switchToGrid();
+}
+
+void Dynamic1DWave::gatherState (double* state)
+{
+    const int numUnknowns = M + Mw;
+    for (int row = 0; row < numUnknowns; ++row)
+    {
+        state[row] = getUnknown (row, 1);
+        state[numUnknowns + row] = getUnknown (row, 2);
+    }
+}
+
+void Dynamic1DWave::scatterState (const double* state, double* u1, double* u2, double* w1, double* w2) const
+{
+    // the boundaries are exactly zero
+    u1[0] = 0;
+    u2[0] = 0;
+    for (int l = 1; l <= M; ++l)
+    {
+        u1[l] = state[l - 1];
+        u2[l] = state[M + Mw + l - 1];
+    }
+    for (int l = 0; l < Mw; ++l)
+    {
+        w1[l] = state[M + l];
+        w2[l] = state[2 * M + Mw + l];
+    }
+    w1[Mw] = 0;
+    w2[Mw] = 0;
+}
+
+void Dynamic1DWave::buildTransitionMatrix (double* A)
+{
+    // Runs exactly the same steps as calculate() on every unit vector, so A includes all options of the grid
+    const int numUnknowns = M + Mw;
+    const int size = 2 * numUnknowns;
+    
+    std::copy (stateBuffer.begin(), stateBuffer.end(), modalSavedState.begin());
+    double energyEstimateSaved = energyEstimate;
+    
+    for (int col = 0; col < size; ++col)
+    {
+        std::fill (stateBuffer.begin(), stateBuffer.end(), 0);
+        getUnknown (col % numUnknowns, col < numUnknowns ? 1 : 2) = 1;
+        
+        calculateInterpolatedPoints();
+        if (useLowPassConnection)
+            lowPassConnection();
+        calculateScheme();
+        displacementCorrection();
+        
+        // the low-pass connection changes the current state as well
+        for (int row = 0; row < numUnknowns; ++row)
+        {
+            A[row * size + col] = getUnknown (row, 0);
+            A[(numUnknowns + row) * size + col] = getUnknown (row, 1);
+        }
+    }
+    
+    std::copy (modalSavedState.begin(), modalSavedState.end(), stateBuffer.begin());
+    energyEstimate = energyEstimateSaved;
+}
+
+bool Dynamic1DWave::switchToModal()
+{
+    // a network solves the connection between u and w itself, so the update isn't known here
+    if (externalJunctionCorrection)
+        return false;
+    
+    if (!modalEngine.isReady (modalId))
+    {
+        double* A = modalEngine.beginDecomposition (2 * (M + Mw), modalId);
+        if (A == nullptr)
+            return false; // busy, or this update can't be decomposed
+        
+        buildTransitionMatrix (A);
+        modalEngine.decompose();
+        if (!modalEngine.isReady (modalId))
+            return false;
+    }
+    
+    gatherState (modalState.data());
+    if (!modalEngine.project (modalState.data(), modalId))
+        return false;
+    
+    const double sumOfSquares = modalEngine.getSumOfSquares();
+    modalEnergyScale = sumOfSquares > 0 ? energyEstimate / sumOfSquares : 0;
+    
+    modalActive = true;
+    modalSwitchRequested = false;
+    return true;
+}
+
+void Dynamic1DWave::switchToGrid()
+{
+    modalEngine.reconstruct (modalState.data());
+    scatterState (modalState.data(), u[1], u[2], w[1], w[2]);
+    
+    modalActive = false;
+    staticCount = 0;
+}
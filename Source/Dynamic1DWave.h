@@ -12,10 +12,12 @@
 
 #include <JuceHeader.h>
 #include "Global.h"
+#include "ModalEngine.h"
+#include "VibratingString.h"
 //==============================================================================
 /*
 */
-class Dynamic1DWave  : public juce::Component
+class Dynamic1DWave  : public juce::Component, public VibratingString
 {
 public:
     Dynamic1DWave (NamedValueSet& parameters, double k);
@@ -24,8 +26,12 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
-    Path visualiseState (double visualScaling, Graphics& g);
-    void calculate();
+    // Renders the state and adds a row to the waterfall (so that it scrolls at the rate this is called at), paint() only
+    // draws the images. Call from a timer on the message thread.
+    void updateVisualisation();
+    void visualiseState (double visualScaling, int height); // fills columnMin and columnMax
+    void setShowWaterfall (bool show) { showWaterfall = show; resized(); repaint(); }; // space-time view of the string below the state
+    void calculate() override;
     
     void recalculateCoeffs();
     void addRemovePoint();
@@ -34,25 +40,112 @@ public:
     void lowPassConnection();
     
     void calculateScheme();
+    void calculateImplicitScheme(); // called by calculateScheme when theta != 0
+    void factoriseImplicitScheme(); // called by calculateImplicitScheme when the matrix has changed
     void displacementCorrection();
 
-    void updateStates();
+    void updateStates() override;
     
-    double getOutput (double ratio) { int idx = floor(Nint * ratio);
+    double getOutput (double ratio) override { int idx = floor(Nint * ratio);
+        if (modalActive)
+            return modalEngine.getOutput (getStateRow (idx));
         if (idx <= M)
             return u[1][idx];
         else
             return w[1][idx-M-1];
     };
     
-    void excite();
+    void excite() override;
     
-    void changeWavespeed (double val) { cToUse = val; }; // c is only used once per sample (before everything else)
-    void updateParams() { c = cToUse; };
+    // Connections and external forces (call after calculate() and before updateStates()). The position is
+    // Nint * ratio in the same indexing as getOutput, interpolated linearly between two points, ignoring the boundaries.
+    void getConnectionPoints (double ratio, int& idx, double& weight0, double& weight1);
+    double getStateAt (double ratio, int timeIdx);
+    double& getState (int idx, int timeIdx) { return idx <= M ? u[timeIdx][idx] : w[timeIdx][idx - M - 1]; }; // idx in the order u_0, ..., u_M, w_0, ..., w_Mw
+    void addForceAt (double ratio, double force); // adds k^2/h * force to the next state
+    double getForceScaling() { return k * k / h; };
+    
+    // Energy that addForceAt added since the last call (the work force * (u^{n+1} - u^{n-1}) / 2, so
+    // exact as long as every point gets at most one force per sample) and starts counting again
+    double takeInjectedEnergy() { double energy = injectedEnergy; injectedEnergy = 0; return energy; };
+    int getNint() { return Nint; };
+    
+    // Lets a network solve the connection between u_M and w_0 (index M and M + 1) together with its other connections
+    void setExternalJunctionCorrection (bool external) { externalJunctionCorrection = external; invalidateModes(); };
+    int getJunctionIndex() { return M; };
+    void getJunctionCoefficients (double& invAlpha, double& betaOverAlpha);
+    
+    // Idle detection: a string whose energy estimate stays below idleThreshold for idleHoldSamples is frozen (all states zero) until excited again.
+    // While modal synthesis is active the estimate comes from the modes, and a string below the threshold doesn't switch to them.
+    void setIdleDetection (bool useIdleDetection) { idleDetection = useIdleDetection; if (!idleDetection) wake(); };
+    bool isSleeping() { return sleeping; };
+    void wake() { sleeping = false; idleCount = 0; };
+    
+    double getEnergy() override; // discrete energy of the current state (excluding the connection between u and w)
+    
+    // Stability watchdog
+    double getStateSumOfSquares(); // over all time levels of the grid (or the modal coordinates while those are active), not finite if any of the states is not
+    void resetState(); // zeros all states (the string goes to sleep if idle detection is on)
+    void scaleState (double gain); // scales all time levels (switches back to the grid if modal synthesis is active)
+    
+    // Modal synthesis: once c has been static for modalHoldSamples, the grid state is projected onto the eigenvectors of
+    // the update of the grid until c changes again. The first call to setModalSynthesis (true) allocates.
+    void setModalSynthesis (bool useModalSynthesis);
+    bool isModalActive() { return modalActive; };
+    int getNumModes() { return modalActive ? modalEngine.getNumActiveModes() : 0; };
+    
+    // The eigendecomposition takes too long for the audio thread, so it can run in the background. The switch then happens
+    // at the first sample after it is done, so to reproduce a session exactly, switch with requestModalSwitch() instead.
+    void setBackgroundModalDecomposition (bool background) { modalEngine.setBackgroundDecomposition (background); };
+    void setAutomaticModalSwitch (bool automatic) { automaticModalSwitch = automatic; };
+    void requestModalSwitch() { modalSwitchRequested = true; }; // switches in the next calculate() (decomposing right there unless that happens in the background)
+    
+    // Parameters of the connection between u and w
+    void setLowPassConnection (bool useLowPass, double exponent) { useLowPassConnection = useLowPass; lpExponent = exponent; invalidateModes(); };
+    void setDisplacementCorrection (double sig0ToSet, double etaDivToSet, double epsilonToSet) { sig0 = sig0ToSet; etaDiv = etaDivToSet; epsilon = epsilonToSet; invalidateModes(); };
+    double getJunctionDiscontinuity() { return modalActive ? 0 : std::abs (w[1][0] - u[1][M]); };
+    
+    // Implicit theta-scheme: theta = 0 is the explicit scheme, theta >= 0.25 is stable for any lambdaSq. The grid spacing is
+    // h = gridScaling * c * k (set through the "gridScaling" parameter) so a gridScaling > 1 runs on a coarser grid.
+    bool setTheta (double thetaToSet); // returns false (and keeps the current theta) if theta is unstable for this gridScaling
+    static bool isStableTheta (double theta, double gridScaling, bool printReason = false);
+    double getTheta() { return theta; };
+    double getGridScaling() { return gridScaling; };
+    static double getOptimalTheta (double gridScaling) { return gridScaling >= 1.0 ? (1.0 - gridScaling * gridScaling) / 12.0 : 0.25; }; // fourth-order accurate in space and time for gridScaling >= 1
+    
+    void changeWavespeed (double val) override { cToUse = val; }; // c is only used once per sample (before everything else)
+    void updateParams() override { c = cToUse; };
+    double getWavespeed() override { return c; };
+    double getLength() override { return L; };
     
     void saveToFiles();
     void closeFiles();
+    
+    // Binary checkpoint of the full simulation state (all time levels, grid sizes and parameters)
+    size_t getCheckpointSize() const { return sizeof (CheckpointHeader) + stateBuffer.size() * sizeof (double); };
+    void saveCheckpoint (void* dest) const; // dest needs to hold at least getCheckpointSize() bytes. The modes are saved as the grid state they represent.
+    void saveCheckpoint (MemoryBlock& dest) const;
+    bool restoreCheckpoint (const void* src, size_t size); // does not allocate (unless it turns on modal synthesis for the first time)
+    
+    // layout of the start of a checkpoint, followed by the state buffer
+    struct CheckpointHeader
+    {
+        uint32 magic, version;
+        int32 uSize, wSize;
+        int32 Nint, NintPrev, M, Mw;
+        int32 sleeping, idleCount, staticCount;
+        int32 idleDetection, modalSynthesis, externalJunctionCorrection, useLowPassConnection;
+        int32 uIdx[3], wIdx[3]; // which block of the state buffer each time level points to
+        double k, N, c, cToUse, lambdaSq, h, L, alf, alfTick, lpExponent, sig0, etaDiv, epsilon, theta, gridScaling, energyEstimate;
+    };
+    
 private:
+    
+    static const uint32 checkpointMagic = 0x44315744; // "DW1D"
+    static const uint32 checkpointVersion = 5;
+    static bool isValidHeader (const CheckpointHeader& header, int uSize, int wSize);
+    
+
     double k;        // One over the samplerate
     int Nint, NintPrev, M, Mw; // integer number of points
     
@@ -62,12 +155,14 @@ private:
     
     double alf, alfTick;
     
+    // all states (3 time levels of u followed by 3 time levels of w) live in one contiguous buffer
+    std::vector<double> stateBuffer;
+    int uSize, wSize;
+    
     // states u
-    std::vector<std::vector<double>> uStates;
     std::vector<double*> u;
     
     // states w
-    std::vector<std::vector<double>> wStates;
     std::vector<double*> w;
 
     // virtual grid points used to calculate inner boundaries
@@ -75,8 +170,78 @@ private:
     std::vector<double> quadIp;
     std::vector<double> customIp;
     
+    bool useLowPassConnection = false;
     double lpExponent = 10;
     
+    // displacement correction
+    double sig0 = 1.0;
+    double etaDiv = 1.0;
+    double epsilon = 0;
+    bool externalJunctionCorrection = false;
+    
+    // implicit scheme
+    double theta = 0;
+    double gridScaling;
+    std::vector<double> implicitBand; // 5 diagonals per row (columns i - 2 to i + 2), LU factorised
+    double factorisedThetaLambdaSq = 0; // what implicitBand was factorised for
+    int factorisedM = -1, factorisedMw = -1;
+    double factorisedQuadIp[3];
+    std::vector<double> implicitRhs;  // right hand side, overwritten by the solution
+    
+    // idle detection
+    void checkIdle();
+    void checkModalIdle(); // estimates the energy from the modes every modalIdleInterval samples
+    bool idleDetection = false;
+    bool sleeping = false;
+    double energyEstimate = 0; // sum of squared velocity and (scaled) squared slope, updated in calculateScheme
+    
+    double injectedEnergy = 0; // by addForceAt since the last takeInjectedEnergy()
+    double idleThreshold = 1e-12;
+    int idleCount = 0;
+    int idleHoldSamples = 1024;
+    
+    // modal synthesis
+    bool switchToModal(); // returns false if the decomposition of the current update isn't available (yet)
+    void switchToGrid();
+    void invalidateModes() { ++modalId; if (modalActive) switchToGrid(); }; // the update of the grid has changed
+    double getGridPosition (int idx) { return idx <= M ? idx * h : (idx - 1 + alf) * h; }; // w_0 lies alf * h to the right of u_M
+    double getGridLength() { return (M + Mw + alf) * h; };
+    
+    // The state vector of the modal engine is (x^n, x^{n-1}) with x = (u_1, ..., u_M, w_0, ..., w_{Mw-1}), the same unknowns as the implicit scheme
+    int getStateRow (int idx) { return idx > M + Mw ? -1 : idx - 1; }; // idx in the order of getState, -1 for the boundaries
+    double& getUnknown (int row, int timeIdx) { return row < M ? u[timeIdx][row + 1] : w[timeIdx][row - M]; };
+    const double& getUnknown (int row, int timeIdx) const { return row < M ? u[timeIdx][row + 1] : w[timeIdx][row - M]; };
+    void gatherState (double* state);
+    void scatterState (const double* state, double* u1, double* u2, double* w1, double* w2) const;
+    void buildTransitionMatrix (double* A); // column j is one sample of the grid applied to the j-th unit vector
+    
+    ModalEngine modalEngine;
+    bool modalSynthesis = false;
+    bool modalActive = false;
+    bool automaticModalSwitch = true;
+    bool modalSwitchRequested = false;
+    double cStatic;
+    int staticCount = 0;
+    int modalHoldSamples = 4096;
+    int modalIdleInterval = 256; // the sum of squares of the modes costs about as much as a sample
+    double modalEnergyScale = 0; // energy estimate per squared modal amplitude at the switch
+    int64 modalId = 0; // changes whenever the update of the grid does
+    std::vector<double> modalState, modalSavedState, modalGrid;
+    std::vector<double> displayState; // only used by visualiseState (the message thread)
+    
+    double calculateEnergy (const double* u1, const double* u2, const double* w1, const double* w2);
+    
+    // visualisation
+    void addWaterfallRow(); // from columnMin and columnMax
+    void drawWaterfall (Graphics& g, Rectangle<int> area);
+    
+    Rectangle<int> stringArea, waterfallArea; // set by resized()
+    double visualScaling = 500;
+    Image stateImage, waterfallImage;
+    std::vector<float> columnMin, columnMax; // envelope of the state per pixel column
+    bool showWaterfall = true;
+    int waterfallRow = 0;
+    
     std::ofstream uState, wState, alfSave, MSave, MwSave;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Dynamic1DWave)
@@ -0,0 +1,625 @@
+/*
+  ==============================================================================
+
+    EigenDecomposition.cpp
+    Created: 19 Oct 2026 11:02:38am
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "EigenDecomposition.h"
+
+EigenDecomposition::EigenDecomposition (int maxSize)
+{
+    V.resize (maxSize * maxSize, 0);
+    A.resize (maxSize * maxSize, 0);
+    d.resize (maxSize, 0);
+    e.resize (maxSize, 0);
+    ort.resize (maxSize, 0);
+    pivots.resize (maxSize, 0);
+}
+
+bool EigenDecomposition::decompose (int sizeToUse)
+{
+    size = sizeToUse;
+    jassert (size * size <= static_cast<int> (V.size()));
+
+    reduceToHessenberg (A.data());
+    if (!reduceToSchur (A.data()))
+        return false;
+    backSubstitute (A.data());
+    return factorise();
+}
+
+void EigenDecomposition::reduceToHessenberg (double* hess)
+{
+    // Householder reflections, accumulated in V
+    const int n = size;
+    auto H = [&] (int i, int j) -> double& { return hess[i * n + j]; };
+    auto Vm = [&] (int i, int j) -> double& { return V[i * n + j]; };
+
+    const int low = 0;
+    const int high = n - 1;
+
+    for (int m = low + 1; m <= high - 1; ++m)
+    {
+        double scale = 0;
+        for (int i = m; i <= high; ++i)
+            scale += std::abs (H (i, m - 1));
+
+        if (scale == 0)
+            continue;
+
+        double h = 0;
+        for (int i = high; i >= m; --i)
+        {
+            ort[i] = H (i, m - 1) / scale;
+            h += ort[i] * ort[i];
+        }
+        double g = std::sqrt (h);
+        if (ort[m] > 0)
+            g = -g;
+        h = h - ort[m] * g;
+        ort[m] = ort[m] - g;
+
+        // H = (I - u u' / h) H (I - u u' / h)
+        for (int j = m; j < n; ++j)
+        {
+            double f = 0;
+            for (int i = high; i >= m; --i)
+                f += ort[i] * H (i, j);
+            f = f / h;
+            for (int i = m; i <= high; ++i)
+                H (i, j) -= f * ort[i];
+        }
+
+        for (int i = 0; i <= high; ++i)
+        {
+            double f = 0;
+            for (int j = high; j >= m; --j)
+                f += ort[j] * H (i, j);
+            f = f / h;
+            for (int j = m; j <= high; ++j)
+                H (i, j) -= f * ort[j];
+        }
+        ort[m] = scale * ort[m];
+        H (m, m - 1) = scale * g;
+    }
+
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            Vm (i, j) = i == j ? 1.0 : 0.0;
+
+    for (int m = high - 1; m >= low + 1; --m)
+    {
+        if (H (m, m - 1) == 0)
+            continue;
+
+        for (int i = m + 1; i <= high; ++i)
+            ort[i] = H (i, m - 1);
+        for (int j = m; j <= high; ++j)
+        {
+            double g = 0;
+            for (int i = m; i <= high; ++i)
+                g += ort[i] * Vm (i, j);
+
+            // double division avoids possible underflow
+            g = (g / ort[m]) / H (m, m - 1);
+            for (int i = m; i <= high; ++i)
+                Vm (i, j) += g * ort[i];
+        }
+    }
+}
+
+bool EigenDecomposition::reduceToSchur (double* hess)
+{
+    // Francis double shift QR iterations on the Hessenberg matrix, accumulated in V
+    const int nn = size;
+    auto H = [&] (int i, int j) -> double& { return hess[i * nn + j]; };
+    auto Vm = [&] (int i, int j) -> double& { return V[i * nn + j]; };
+
+    int n = nn - 1;
+    const int low = 0;
+    const int high = nn - 1;
+    const double eps = std::pow (2.0, -52.0);
+    double exshift = 0;
+    double p = 0, q = 0, r = 0, s = 0, z = 0, w, x, y;
+
+    double norm = 0;
+    for (int i = 0; i < nn; ++i)
+        for (int j = std::max (i - 1, 0); j < nn; ++j)
+            norm += std::abs (H (i, j));
+
+    int iter = 0;
+    int totalIter = 0;
+    const int maxTotalIter = 100 * nn;
+
+    while (n >= low)
+    {
+        // look for a single small subdiagonal element
+        int l = n;
+        while (l > low)
+        {
+            s = std::abs (H (l - 1, l - 1)) + std::abs (H (l, l));
+            if (s == 0)
+                s = norm;
+            if (std::abs (H (l, l - 1)) < eps * s)
+                break;
+            --l;
+        }
+
+        if (l == n)
+        {
+            // one root
+            H (n, n) = H (n, n) + exshift;
+            d[n] = H (n, n);
+            e[n] = 0;
+            --n;
+            iter = 0;
+        }
+        else if (l == n - 1)
+        {
+            // two roots
+            w = H (n, n - 1) * H (n - 1, n);
+            p = (H (n - 1, n - 1) - H (n, n)) / 2.0;
+            q = p * p + w;
+            z = std::sqrt (std::abs (q));
+            H (n, n) = H (n, n) + exshift;
+            H (n - 1, n - 1) = H (n - 1, n - 1) + exshift;
+            x = H (n, n);
+
+            if (q >= 0)
+            {
+                // real pair
+                z = p >= 0 ? p + z : p - z;
+                d[n - 1] = x + z;
+                d[n] = d[n - 1];
+                if (z != 0)
+                    d[n] = x - w / z;
+                e[n - 1] = 0;
+                e[n] = 0;
+                x = H (n, n - 1);
+                s = std::abs (x) + std::abs (z);
+                p = x / s;
+                q = z / s;
+                r = std::sqrt (p * p + q * q);
+                p = p / r;
+                q = q / r;
+
+                // row modification
+                for (int j = n - 1; j < nn; ++j)
+                {
+                    z = H (n - 1, j);
+                    H (n - 1, j) = q * z + p * H (n, j);
+                    H (n, j) = q * H (n, j) - p * z;
+                }
+
+                // column modification
+                for (int i = 0; i <= n; ++i)
+                {
+                    z = H (i, n - 1);
+                    H (i, n - 1) = q * z + p * H (i, n);
+                    H (i, n) = q * H (i, n) - p * z;
+                }
+
+                for (int i = low; i <= high; ++i)
+                {
+                    z = Vm (i, n - 1);
+                    Vm (i, n - 1) = q * z + p * Vm (i, n);
+                    Vm (i, n) = q * Vm (i, n) - p * z;
+                }
+            }
+            else
+            {
+                // complex pair
+                d[n - 1] = x + p;
+                d[n] = x + p;
+                e[n - 1] = z;
+                e[n] = -z;
+            }
+            n = n - 2;
+            iter = 0;
+        }
+        else
+        {
+            if (++totalIter > maxTotalIter)
+                return false;
+
+            // form the shift
+            x = H (n, n);
+            y = 0;
+            w = 0;
+            if (l < n)
+            {
+                y = H (n - 1, n - 1);
+                w = H (n, n - 1) * H (n - 1, n);
+            }
+
+            // Wilkinson's original ad hoc shift
+            if (iter == 10)
+            {
+                exshift += x;
+                for (int i = low; i <= n; ++i)
+                    H (i, i) -= x;
+                s = std::abs (H (n, n - 1)) + std::abs (H (n - 1, n - 2));
+                x = y = 0.75 * s;
+                w = -0.4375 * s * s;
+            }
+
+            // MATLAB's ad hoc shift
+            if (iter == 30)
+            {
+                s = (y - x) / 2.0;
+                s = s * s + w;
+                if (s > 0)
+                {
+                    s = std::sqrt (s);
+                    if (y < x)
+                        s = -s;
+                    s = x - w / ((y - x) / 2.0 + s);
+                    for (int i = low; i <= n; ++i)
+                        H (i, i) -= s;
+                    exshift += s;
+                    x = y = w = 0.964;
+                }
+            }
+
+            ++iter;
+
+            // look for two consecutive small subdiagonal elements
+            int m = n - 2;
+            while (m >= l)
+            {
+                z = H (m, m);
+                r = x - z;
+                s = y - z;
+                p = (r * s - w) / H (m + 1, m) + H (m, m + 1);
+                q = H (m + 1, m + 1) - z - r - s;
+                r = H (m + 2, m + 1);
+                s = std::abs (p) + std::abs (q) + std::abs (r);
+                p = p / s;
+                q = q / s;
+                r = r / s;
+                if (m == l)
+                    break;
+                if (std::abs (H (m, m - 1)) * (std::abs (q) + std::abs (r))
+                    < eps * (std::abs (p) * (std::abs (H (m - 1, m - 1)) + std::abs (z) + std::abs (H (m + 1, m + 1)))))
+                    break;
+                --m;
+            }
+
+            for (int i = m + 2; i <= n; ++i)
+            {
+                H (i, i - 2) = 0;
+                if (i > m + 2)
+                    H (i, i - 3) = 0;
+            }
+
+            // double QR step involving rows l to n and columns m to n
+            for (int k = m; k <= n - 1; ++k)
+            {
+                bool notLast = k != n - 1;
+                if (k != m)
+                {
+                    p = H (k, k - 1);
+                    q = H (k + 1, k - 1);
+                    r = notLast ? H (k + 2, k - 1) : 0.0;
+                    x = std::abs (p) + std::abs (q) + std::abs (r);
+                    if (x == 0)
+                        continue;
+                    p = p / x;
+                    q = q / x;
+                    r = r / x;
+                }
+
+                s = std::sqrt (p * p + q * q + r * r);
+                if (p < 0)
+                    s = -s;
+                if (s == 0)
+                    continue;
+
+                if (k != m)
+                    H (k, k - 1) = -s * x;
+                else if (l != m)
+                    H (k, k - 1) = -H (k, k - 1);
+                p = p + s;
+                x = p / s;
+                y = q / s;
+                z = r / s;
+                q = q / p;
+                r = r / p;
+
+                // row modification
+                for (int j = k; j < nn; ++j)
+                {
+                    p = H (k, j) + q * H (k + 1, j);
+                    if (notLast)
+                    {
+                        p = p + r * H (k + 2, j);
+                        H (k + 2, j) = H (k + 2, j) - p * z;
+                    }
+                    H (k, j) = H (k, j) - p * x;
+                    H (k + 1, j) = H (k + 1, j) - p * y;
+                }
+
+                // column modification
+                for (int i = 0; i <= std::min (n, k + 3); ++i)
+                {
+                    p = x * H (i, k) + y * H (i, k + 1);
+                    if (notLast)
+                    {
+                        p = p + z * H (i, k + 2);
+                        H (i, k + 2) = H (i, k + 2) - p * r;
+                    }
+                    H (i, k) = H (i, k) - p;
+                    H (i, k + 1) = H (i, k + 1) - p * q;
+                }
+
+                for (int i = low; i <= high; ++i)
+                {
+                    p = x * Vm (i, k) + y * Vm (i, k + 1);
+                    if (notLast)
+                    {
+                        p = p + z * Vm (i, k + 2);
+                        Vm (i, k + 2) = Vm (i, k + 2) - p * r;
+                    }
+                    Vm (i, k) = Vm (i, k) - p;
+                    Vm (i, k + 1) = Vm (i, k + 1) - p * q;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void EigenDecomposition::backSubstitute (double* hess)
+{
+    // eigenvectors of the upper (quasi-)triangular Schur form, transformed back with V
+    const int nn = size;
+    auto H = [&] (int i, int j) -> double& { return hess[i * nn + j]; };
+    auto Vm = [&] (int i, int j) -> double& { return V[i * nn + j]; };
+
+    const double eps = std::pow (2.0, -52.0);
+    double p, q, r = 0, s = 0, z = 0, t, w, x, y;
+
+    double norm = 0;
+    for (int i = 0; i < nn; ++i)
+        for (int j = std::max (i - 1, 0); j < nn; ++j)
+            norm += std::abs (H (i, j));
+    if (norm == 0)
+        return;
+
+    for (int n = nn - 1; n >= 0; --n)
+    {
+        p = d[n];
+        q = e[n];
+
+        if (q == 0)
+        {
+            // real vector
+            int l = n;
+            H (n, n) = 1.0;
+            for (int i = n - 1; i >= 0; --i)
+            {
+                w = H (i, i) - p;
+                r = 0;
+                for (int j = l; j <= n; ++j)
+                    r = r + H (i, j) * H (j, n);
+
+                if (e[i] < 0)
+                {
+                    z = w;
+                    s = r;
+                    continue;
+                }
+
+                l = i;
+                if (e[i] == 0)
+                {
+                    H (i, n) = w != 0 ? -r / w : -r / (eps * norm);
+                }
+                else
+                {
+                    // solve the real equations
+                    x = H (i, i + 1);
+                    y = H (i + 1, i);
+                    q = (d[i] - p) * (d[i] - p) + e[i] * e[i];
+                    t = (x * s - z * r) / q;
+                    H (i, n) = t;
+                    if (std::abs (x) > std::abs (z))
+                        H (i + 1, n) = (-r - w * t) / x;
+                    else
+                        H (i + 1, n) = (-s - y * t) / z;
+                }
+
+                // overflow control
+                t = std::abs (H (i, n));
+                if ((eps * t) * t > 1)
+                    for (int j = i; j <= n; ++j)
+                        H (j, n) = H (j, n) / t;
+            }
+        }
+        else if (q < 0)
+        {
+            // complex vector (the last component imaginary so the matrix is triangular)
+            int l = n - 1;
+            if (std::abs (H (n, n - 1)) > std::abs (H (n - 1, n)))
+            {
+                H (n - 1, n - 1) = q / H (n, n - 1);
+                H (n - 1, n) = -(H (n, n) - p) / H (n, n - 1);
+            }
+            else
+            {
+                complexDivide (0.0, -H (n - 1, n), H (n - 1, n - 1) - p, q, H (n - 1, n - 1), H (n - 1, n));
+            }
+            H (n, n - 1) = 0;
+            H (n, n) = 1;
+
+            for (int i = n - 2; i >= 0; --i)
+            {
+                double ra = 0, sa = 0, vr, vi;
+                for (int j = l; j <= n; ++j)
+                {
+                    ra = ra + H (i, j) * H (j, n - 1);
+                    sa = sa + H (i, j) * H (j, n);
+                }
+                w = H (i, i) - p;
+
+                if (e[i] < 0)
+                {
+                    z = w;
+                    r = ra;
+                    s = sa;
+                    continue;
+                }
+
+                l = i;
+                if (e[i] == 0)
+                {
+                    complexDivide (-ra, -sa, w, q, H (i, n - 1), H (i, n));
+                }
+                else
+                {
+                    // solve the complex equations
+                    x = H (i, i + 1);
+                    y = H (i + 1, i);
+                    vr = (d[i] - p) * (d[i] - p) + e[i] * e[i] - q * q;
+                    vi = (d[i] - p) * 2.0 * q;
+                    if (vr == 0 && vi == 0)
+                        vr = eps * norm * (std::abs (w) + std::abs (q) + std::abs (x) + std::abs (y) + std::abs (z));
+                    complexDivide (x * r - z * ra + q * sa, x * s - z * sa - q * ra, vr, vi, H (i, n - 1), H (i, n));
+                    if (std::abs (x) > std::abs (z) + std::abs (q))
+                    {
+                        H (i + 1, n - 1) = (-ra - w * H (i, n - 1) + q * H (i, n)) / x;
+                        H (i + 1, n) = (-sa - w * H (i, n) - q * H (i, n - 1)) / x;
+                    }
+                    else
+                    {
+                        complexDivide (-r - y * H (i, n - 1), -s - y * H (i, n), z, q, H (i + 1, n - 1), H (i + 1, n));
+                    }
+                }
+
+                // overflow control
+                t = std::max (std::abs (H (i, n - 1)), std::abs (H (i, n)));
+                if ((eps * t) * t > 1)
+                {
+                    for (int j = i; j <= n; ++j)
+                    {
+                        H (j, n - 1) = H (j, n - 1) / t;
+                        H (j, n) = H (j, n) / t;
+                    }
+                }
+            }
+        }
+    }
+
+    // back transformation to the eigenvectors of the original matrix
+    for (int j = nn - 1; j >= 0; --j)
+    {
+        for (int i = 0; i < nn; ++i)
+        {
+            z = 0;
+            for (int k = 0; k <= j; ++k)
+                z = z + Vm (i, k) * H (k, j);
+            Vm (i, j) = z;
+        }
+    }
+
+    // scale every (pair of) column(s) to a maximum of one, so the modal amplitudes are comparable
+    for (int j = 0; j < nn; ++j)
+    {
+        int numColumns = e[j] > 0 ? 2 : 1;
+        double maxVal = 0;
+        for (int i = 0; i < nn; ++i)
+            for (int col = j; col < j + numColumns; ++col)
+                maxVal = std::max (maxVal, std::abs (Vm (i, col)));
+        if (maxVal > 0)
+            for (int i = 0; i < nn; ++i)
+                for (int col = j; col < j + numColumns; ++col)
+                    Vm (i, col) /= maxVal;
+        j += numColumns - 1;
+    }
+}
+
+bool EigenDecomposition::factorise()
+{
+    // LU with partial pivoting
+    const int n = size;
+    std::copy (V.begin(), V.begin() + n * n, A.begin());
+    auto LU = [&] (int i, int j) -> double& { return A[i * n + j]; };
+
+    for (int col = 0; col < n; ++col)
+    {
+        int pivot = col;
+        for (int i = col + 1; i < n; ++i)
+            if (std::abs (LU (i, col)) > std::abs (LU (pivot, col)))
+                pivot = i;
+        pivots[col] = pivot;
+
+        if (LU (pivot, col) == 0)
+            return false;
+
+        if (pivot != col)
+            for (int j = 0; j < n; ++j)
+                std::swap (LU (pivot, j), LU (col, j));
+
+        for (int i = col + 1; i < n; ++i)
+        {
+            double factor = LU (i, col) / LU (col, col);
+            LU (i, col) = factor;
+            if (factor == 0)
+                continue;
+            for (int j = col + 1; j < n; ++j)
+                LU (i, j) -= factor * LU (col, j);
+        }
+    }
+    return true;
+}
+
+void EigenDecomposition::solve (const double* b, double* x) const
+{
+    const int n = size;
+    std::copy (b, b + n, x);
+
+    for (int col = 0; col < n; ++col)
+        if (pivots[col] != col)
+            std::swap (x[col], x[pivots[col]]);
+
+    for (int i = 1; i < n; ++i)
+    {
+        double sum = x[i];
+        const double* row = &A[i * n];
+        for (int j = 0; j < i; ++j)
+            sum -= row[j] * x[j];
+        x[i] = sum;
+    }
+
+    for (int i = n - 1; i >= 0; --i)
+    {
+        double sum = x[i];
+        const double* row = &A[i * n];
+        for (int j = i + 1; j < n; ++j)
+            sum -= row[j] * x[j];
+        x[i] = sum / row[i];
+    }
+}
+
+void EigenDecomposition::complexDivide (double xr, double xi, double yr, double yi, double& resultReal, double& resultImag)
+{
+    double r, den;
+    if (std::abs (yr) > std::abs (yi))
+    {
+        r = yi / yr;
+        den = yr + r * yi;
+        resultReal = (xr + r * xi) / den;
+        resultImag = (xi - r * xr) / den;
+    }
+    else
+    {
+        r = yr / yi;
+        den = yi + r * yr;
+        resultReal = (r * xr + xi) / den;
+        resultImag = (r * xi - xr) / den;
+    }
+}
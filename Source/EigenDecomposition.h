@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    EigenDecomposition.h
+    Created: 19 Oct 2026 11:02:38am
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Eigenvalues and eigenvectors of a general real matrix A, such that A V = V D
+    (Hessenberg reduction followed by the shifted QR algorithm, as in EISPACK's
+    orthes and hqr2). D is block diagonal: a real eigenvalue is a 1x1 block and
+    a complex pair a +/- ib is the 2x2 block [a b; -b a] with the real and
+    imaginary part of its eigenvector in two consecutive columns of V, so
+    everything stays real. V is LU factorised as well (into the memory of A,
+    which isn't needed anymore by then), so that a vector can be expressed in
+    the eigenvectors.
+
+    All matrices are row major. Nothing is allocated after the constructor.
+*/
+class EigenDecomposition
+{
+public:
+    EigenDecomposition (int maxSize);
+
+    double* getMatrix() { return A.data(); }; // fill in A (size x size) before calling decompose()
+
+    // A is destroyed. Returns false if the QR iteration doesn't converge or V is singular.
+    bool decompose (int size);
+
+    int getSize() const { return size; };
+    const double* getEigenvectors() const { return V.data(); };
+    double getRealPart (int i) const { return d[i]; };
+    double getImagPart (int i) const { return e[i]; }; // > 0 for the first and < 0 for the second column of a complex pair
+
+    // x = V^-1 b
+    void solve (const double* b, double* x) const;
+
+private:
+    void reduceToHessenberg (double* H);
+    bool reduceToSchur (double* H);
+    void backSubstitute (double* H);
+    bool factorise();
+
+    // complex division (xr + i xi) / (yr + i yi)
+    static void complexDivide (double xr, double xi, double yr, double yi, double& resultReal, double& resultImag);
+
+    int size = 0;
+    std::vector<double> V, A, d, e, ort; // A holds the LU factors of V after decompose()
+    std::vector<int> pivots;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EigenDecomposition)
+};
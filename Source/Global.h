@@ -19,6 +19,26 @@ namespace Global
     
     static const bool useCVec = false;
     
+    // h = gridScaling * c * k. A gridScaling above 1 needs fewer points and is most accurate with
+    // theta = Dynamic1DWave::getOptimalTheta (gridScaling); below 1 it needs theta >= 0.25.
+    static const double gridScaling = 1.0;
+    static const double theta = 0.0;
+    
+    // switch the grid to its modes while c is static. This is exact, but an excitation as broadband as the
+    // pluck keeps about N modes sounding, which costs as much as the grid (and 5 MB per string for the decompositions)
+    static const bool useModalSynthesis = false;
+    
+    // lossless string as a fractional delay waveguide instead of the grid (not visualised)
+    static const bool useWaveguide = false;
+    
+    // resonator mode: the live input is applied as a force at these (fractional) positions of the string,
+    // scaled by inputGain (a full scale input then gives a displacement in the order of excite())
+    static const std::vector<double> injectionRatios { 0.13, 0.71 };
+    static const double inputGain = 1e4;
+    
+    // reset or damp the string (once per block) when the scheme goes unstable
+    static const bool useStabilityWatchdog = true;
+    
     static std::vector<double> linspace (double start, double finish, int N)
     {
         std::vector<double> res (N, 0);
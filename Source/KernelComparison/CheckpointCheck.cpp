@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    CheckpointCheck.cpp
+    Created: 19 Oct 2026 12:09:47pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "CheckpointCheck.h"
+
+bool CheckpointCheck::run()
+{
+    // non-default settings, so that they have to be restored as well
+    std::unique_ptr<Dynamic1DWave> original = createWave (cVec[0]);
+    original->setIdleDetection (true);
+    original->setLowPassConnection (true, 10);
+    
+    const size_t half = cVec.size() / 2;
+    for (size_t n = 0; n < half; ++n)
+        step (*original, cVec[n]);
+    
+    MemoryBlock checkpoint;
+    original->saveCheckpoint (checkpoint);
+    
+    std::unique_ptr<Dynamic1DWave> restored = createWave (cVec[0]);
+    if (!restored->restoreCheckpoint (checkpoint.getData(), original->getCheckpointSize()))
+    {
+        std::cout << "checkpoint: could not restore FAILED" << std::endl;
+        return false;
+    }
+    
+    // everything that was saved should have been restored
+    MemoryBlock resaved;
+    restored->saveCheckpoint (resaved);
+    bool identical = memcmp (resaved.getData(), checkpoint.getData(), original->getCheckpointSize()) == 0;
+    
+    // the remaining sweep (including points being added) should be bit-exact
+    double maxAbsError = 0;
+    for (size_t n = half; n < cVec.size(); ++n)
+    {
+        double originalOut = step (*original, cVec[n]);
+        double restoredOut = step (*restored, cVec[n]);
+        maxAbsError = std::max (maxAbsError, std::abs (restoredOut - originalOut));
+    }
+
+    // a string created at a fractional N (rather than swept to it) should round trip as well
+    std::unique_ptr<Dynamic1DWave> fractional = createWave (fractionalWavespeed);
+    for (size_t n = 0; n < half; ++n)
+        step (*fractional, fractionalWavespeed);
+
+    MemoryBlock fractionalCheckpoint;
+    fractional->saveCheckpoint (fractionalCheckpoint);
+    std::unique_ptr<Dynamic1DWave> fractionalRestored = createWave (cVec[0]);
+    bool restoresFractional = fractionalRestored->restoreCheckpoint (fractionalCheckpoint.getData(), fractional->getCheckpointSize());
+    for (size_t n = 0; restoresFractional && n < half; ++n)
+        maxAbsError = std::max (maxAbsError, std::abs (step (*fractionalRestored, fractionalWavespeed) - step (*fractional, fractionalWavespeed)));
+
+    // two time levels pointing to the same block can't be restored
+    std::vector<char> corrupt (original->getCheckpointSize());
+    original->saveCheckpoint (corrupt.data());
+    const int32 duplicate = 0;
+    std::unique_ptr<Dynamic1DWave> rejected = createWave (cVec[0]);
+    for (size_t idx = 0; idx < 3; ++idx)
+        memcpy (&corrupt[offsetof (Dynamic1DWave::CheckpointHeader, uIdx) + idx * sizeof (int32)], &duplicate, sizeof (int32));
+    bool rejectsCorrupt = !rejected->restoreCheckpoint (corrupt.data(), corrupt.size());
+    
+    bool passed = identical && maxAbsError == 0 && restoresFractional && rejectsCorrupt;
+    std::cout << "checkpoint: max abs error " << maxAbsError
+              << (identical ? "" : ", saves differently after restoring")
+              << (restoresFractional ? "" : ", can't restore a string at c = " + String (fractionalWavespeed))
+              << (rejectsCorrupt ? "" : ", accepts a corrupt checkpoint")
+              << (passed ? "" : " FAILED") << std::endl;
+    return passed;
+}
@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    CheckpointCheck.h
+    Created: 19 Oct 2026 12:09:47pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "KernelCheck.h"
+
+//==============================================================================
+/*
+    Saves a string halfway the sweep, restores it into a fresh instance and
+    checks that both continue identically. A string created at a fractional N
+    has to round trip as well and a corrupt checkpoint has to be rejected.
+*/
+class CheckpointCheck : public KernelCheck
+{
+public:
+    CheckpointCheck (double fs, double L = 1) : KernelCheck (fs, L) {};
+    
+    bool run() override;
+    
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CheckpointCheck)
+};
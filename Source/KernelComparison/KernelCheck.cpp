@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    KernelCheck.cpp
+    Created: 19 Oct 2026 12:06:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "KernelCheck.h"
+
+KernelCheck::KernelCheck (double fs, double L) : fs (fs), L (L)
+{
+    // same sweep as Global::useCVec uses
+    cVec = Global::linspace (294, 588, fs);
+}
+
+std::unique_ptr<Dynamic1DWave> KernelCheck::createWave (double c, double gridScaling)
+{
+    NamedValueSet parameters;
+    parameters.set ("c", c);
+    parameters.set ("L", L);
+    parameters.set ("gridScaling", gridScaling);
+    
+    return std::make_unique<Dynamic1DWave> (parameters, 1.0 / fs);
+}
+
+double KernelCheck::step (VibratingString& string, double c)
+{
+    string.changeWavespeed (c);
+    string.updateParams();
+    string.calculate();
+    string.updateStates();
+    return string.getOutput (outputRatio);
+}
+
+double KernelCheck::step (Dynamic1DWave& wave, double c, const std::function<void (Dynamic1DWave&, size_t)>& input, size_t n)
+{
+    wave.changeWavespeed (c);
+    wave.updateParams();
+    wave.calculate();
+    if (input)
+        input (wave, n);
+    wave.updateStates();
+    return wave.getOutput (outputRatio);
+}
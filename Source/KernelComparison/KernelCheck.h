@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    KernelCheck.h
+    Created: 19 Oct 2026 12:06:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Dynamic1DWave.h"
+#include "../Global.h"
+
+//==============================================================================
+/*
+    One of the headless checks of --compare-kernels (see KernelComparison).
+    Holds what all of them share: the sample rate, the length of the string,
+    the default wave speed sweep and how a string is created and stepped.
+*/
+class KernelCheck
+{
+public:
+    KernelCheck (double fs, double L = 1);
+    virtual ~KernelCheck() = default;
+    
+    // prints the results and returns true if everything passed
+    virtual bool run() = 0;
+    
+protected:
+    std::unique_ptr<Dynamic1DWave> createWave (double c, double gridScaling = 1.0);
+    
+    // calculates one sample and returns the output
+    double step (VibratingString& string, double c);
+    
+    // calculates one sample (applying the input, if any) and returns the output
+    double step (Dynamic1DWave& wave, double c, const std::function<void (Dynamic1DWave&, size_t)>& input = nullptr, size_t n = 0);
+    
+    double fs, L;
+    double outputRatio = 0.2;
+    int energyInterval = 16; // samples between energy checks (the energy of the modes has to be reconstructed)
+    double fractionalWavespeed = 310; // N isn't an integer and its floor is even
+    
+    std::vector<double> cVec; // wave speed trajectory
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KernelCheck)
+};
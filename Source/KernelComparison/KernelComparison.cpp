@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+    KernelComparison.cpp
+    Created: 19 Oct 2026 10:12:41am
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "KernelComparison.h"
+#include "CheckpointCheck.h"
+#include "ThetaBoundsCheck.h"
+#include "StringNetworkCheck.h"
+#include "WaveguideCheck.h"
+
+KernelComparison::KernelComparison (double fs, double L) : KernelCheck (fs, L)
+{
+    paths = getDefaultPaths();
+    
+    checks.push_back (std::make_unique<CheckpointCheck> (fs, L));
+    checks.push_back (std::make_unique<ThetaBoundsCheck> (fs, L));
+    checks.push_back (std::make_unique<StringNetworkCheck> (fs, L));
+    checks.push_back (std::make_unique<WaveguideCheck> (fs, L));
+}
+
+std::vector<KernelComparison::CandidatePath> KernelComparison::getDefaultPaths()
+{
+    std::vector<CandidatePath> defaultPaths;
+    
+    // sanity check: the reference against itself
+    defaultPaths.push_back (CandidatePath ("reference", [] (Dynamic1DWave&) {}, 0, 0));
+    
+    // A sleeping string outputs zeros instead of values below the idle threshold. The string is lossless, so both strings
+    // are damped until well after the candidate fell asleep (during the sweep) and then excited again.
+    const size_t dampedSamples = static_cast<size_t> (fs * 0.6);
+    const size_t exciteSample = static_cast<size_t> (fs * 0.75);
+    CandidatePath idlePath ("idle detection", [] (Dynamic1DWave& wave) { wave.setIdleDetection (true); }, 1e-6, 1e-6);
+    idlePath.input = [=] (Dynamic1DWave& wave, size_t n) {
+        if (n < dampedSamples)
+            wave.scaleState (0.999);
+        else if (n == exciteSample)
+            wave.excite();
+    };
+    idlePath.exercised = [] (Dynamic1DWave& wave) { return wave.isSleeping(); };
+    defaultPaths.push_back (idlePath);
+    
+    // static (the string switches to modes) followed by a sweep (and back to the grid). The modes are those of the
+    // grid itself, so the output should be the same for integer as well as fractional N (c = 294 gives N = 150)
+    for (double cStatic : { 294.0, 310.0, 451.3, 600.0 })
+    {
+        std::vector<double> staticSweep (fs * 0.25, cStatic);
+        std::vector<double> sweep = Global::linspace (cStatic, cStatic * 1.5, fs * 0.25);
+        staticSweep.insert (staticSweep.end(), sweep.begin(), sweep.end());
+        CandidatePath modalPath ("modal synthesis (c = " + String (cStatic) + ")", [] (Dynamic1DWave& wave) { wave.setModalSynthesis (true); }, 1e-9, 1e-9);
+        modalPath.trajectory = staticSweep;
+        modalPath.exercised = [] (Dynamic1DWave& wave) { return wave.isModalActive(); };
+        defaultPaths.push_back (modalPath);
+    }
+    
+    // The implicit scheme with the settings it is meant for: fewer points and the optimal theta. Its dispersion differs
+    // from the reference, so both strings start at rest and are driven by a smooth force pulse that only excites the lower
+    // modes (where the scheme is fourth-order accurate). At c = 294 (N = 150) the reference is exact, during a sweep the
+    // moving junction of both grids differs, so the tolerance is looser.
+    const int pulseSamples = static_cast<int> (fs * 0.005);
+    auto addImplicitPath = [&] (double gridScaling, const std::vector<double>& trajectory, double tolerance, double energyTolerance)
+    {
+        CandidatePath implicitPath ("implicit scheme (gridScaling " + String (gridScaling) + (trajectory.front() == trajectory.back() ? ", static)" : ", sweep)"),
+                                    [=] (Dynamic1DWave& wave) { wave.setTheta (Dynamic1DWave::getOptimalTheta (gridScaling)); }, tolerance, energyTolerance);
+        implicitPath.trajectory = trajectory;
+        implicitPath.gridScaling = gridScaling;
+        implicitPath.startAtRest = true;
+        implicitPath.input = [=] (Dynamic1DWave& wave, size_t n) {
+            if (n < static_cast<size_t> (pulseSamples))
+                wave.addForceAt (0.3, 1e4 * 0.5 * (1.0 - cos (2.0 * double_Pi * n / pulseSamples)));
+        };
+        implicitPath.energyStart = pulseSamples;
+        defaultPaths.push_back (implicitPath);
+    };
+    const std::vector<double> staticTrajectory (fs * 0.5, 294);
+    addImplicitPath (1.5, staticTrajectory, 1e-5, 2e-2);
+    addImplicitPath (2.0, staticTrajectory, 5e-5, 2e-2);
+    addImplicitPath (3.0, staticTrajectory, 5e-5, 3e-2);
+    addImplicitPath (2.0, cVec, 2e-3, 5e-2);
+    
+    return defaultPaths;
+}
+
+bool KernelComparison::writeGoldenTrace (const std::string& goldenTraceFile)
+{
+    std::ofstream goldenOut (goldenTraceFile);
+    if (!goldenOut.is_open())
+    {
+        std::cout << "Could not write " << goldenTraceFile << std::endl;
+        return false;
+    }
+    
+    std::unique_ptr<Dynamic1DWave> reference = createWave (cVec[0]);
+    goldenOut.precision (17);
+    for (size_t n = 0; n < cVec.size(); ++n)
+        goldenOut << step (*reference, cVec[n]) << ";\n";
+    
+    std::cout << "Wrote the golden trace to " << goldenTraceFile << std::endl;
+    return true;
+}
+
+bool KernelComparison::checkGoldenTrace (const std::string& goldenTraceFile)
+{
+    std::unique_ptr<Dynamic1DWave> reference = createWave (cVec[0]);
+
+    // a missing trace is a failure, otherwise a typo in the path would pass anything
+    std::ifstream goldenIn (goldenTraceFile);
+    if (!goldenIn.is_open())
+    {
+        std::cout << "golden trace: could not open " << goldenTraceFile << " (write it with --regenerate-golden) FAILED" << std::endl;
+        return false;
+    }
+    
+    double maxAbsError = 0;
+    double goldenValue;
+    char separator;
+    size_t n = 0;
+    while (n < cVec.size() && goldenIn >> goldenValue >> separator)
+    {
+        maxAbsError = std::max (maxAbsError, std::abs (step (*reference, cVec[n]) - goldenValue));
+        ++n;
+    }
+    
+    if (n != cVec.size())
+    {
+        std::cout << "Golden trace has " << n << " samples, expected " << cVec.size() << std::endl;
+        return false;
+    }
+    
+    std::cout << "golden trace: max abs error " << maxAbsError << std::endl;
+    return maxAbsError <= goldenTolerance;
+}
+
+bool KernelComparison::runAll (const std::string& goldenTraceFile)
+{
+    bool allPassed = checkGoldenTrace (goldenTraceFile);
+    for (auto& check : checks)
+        allPassed = check->run() && allPassed;
+    
+    return run() && allPassed;
+}
+
+bool KernelComparison::run()
+{
+    bool allPassed = true;
+    results.clear();
+    
+    for (auto& path : paths)
+    {
+        const std::vector<double>& trajectory = path.trajectory.empty() ? cVec : path.trajectory;
+        std::unique_ptr<Dynamic1DWave> reference = createWave (trajectory[0]);
+        std::unique_ptr<Dynamic1DWave> candidate = createWave (trajectory[0], path.gridScaling);
+        path.configure (*candidate);
+        if (path.startAtRest)
+        {
+            reference->resetState();
+            candidate->resetState();
+        }
+        
+        double refEnergy0 = reference->getEnergy();
+        double candEnergy0 = candidate->getEnergy();
+        
+        Result result { path.name, 0, 0, 0, true };
+        bool exercised = !path.exercised;
+        
+        for (size_t n = 0; n < trajectory.size(); ++n)
+        {
+            double refOut = step (*reference, trajectory[n], path.input, n);
+            double candOut = step (*candidate, trajectory[n], path.input, n);
+            
+            result.maxAbsError = std::max (result.maxAbsError, std::abs (candOut - refOut));
+            if (!exercised)
+                exercised = path.exercised (*candidate);
+            
+            if (n + 1 == path.energyStart)
+            {
+                refEnergy0 = reference->getEnergy();
+                candEnergy0 = candidate->getEnergy();
+            }
+            if (n < path.energyStart || n % energyInterval != 0)
+                continue;
+            result.referenceEnergyDrift = std::max (result.referenceEnergyDrift, std::abs (reference->getEnergy() - refEnergy0) / refEnergy0);
+            result.energyDrift = std::max (result.energyDrift, std::abs (candidate->getEnergy() - candEnergy0) / candEnergy0);
+        }
+        
+        // also catches NaNs
+        result.passed = exercised
+            && result.maxAbsError <= path.tolerance
+            && std::abs (result.energyDrift - result.referenceEnergyDrift) <= path.energyTolerance;
+        
+        std::cout << path.name << ": max abs error " << result.maxAbsError
+                  << ", energy drift " << result.energyDrift
+                  << " (reference " << result.referenceEnergyDrift << ")"
+                  << (exercised ? "" : ", not exercised")
+                  << (result.passed ? "" : " FAILED") << std::endl;
+        
+        allPassed = allPassed && result.passed;
+        results.push_back (result);
+    }
+    return allPassed;
+}
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    KernelComparison.h
+    Created: 19 Oct 2026 10:12:41am
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "KernelCheck.h"
+
+//==============================================================================
+/*
+    Runs the reference (scalar double) implementation of Dynamic1DWave side by
+    side with optimised paths over a wave speed trajectory and reports the
+    maximum absolute error of the output and the energy drift of every path.
+    runAll() also checks the reference against the golden trace (which lives
+    next to this file) and runs the checks of the other features.
+*/
+class KernelComparison : public KernelCheck
+{
+public:
+    struct CandidatePath
+    {
+        CandidatePath (const String& name, std::function<void (Dynamic1DWave&)> configure, double tolerance, double energyTolerance)
+            : name (name), configure (configure), tolerance (tolerance), energyTolerance (energyTolerance) {};
+        
+        String name;
+        std::function<void (Dynamic1DWave&)> configure; // switches a freshly created instance to the optimised path
+        double tolerance;       // maximum absolute error of the output
+        double energyTolerance; // maximum difference between the relative energy drift of the path and the reference
+        
+        std::vector<double> trajectory; // wave speed trajectory for this path (the default sweep if empty)
+        double gridScaling = 1.0;       // of the candidate, the reference always runs at the stability limit (exact for integer N)
+        bool startAtRest = false;       // both strings start at rest instead of with the initial excitation
+        std::function<void (Dynamic1DWave&, size_t)> input; // applied to both strings after calculate() of sample n
+        size_t energyStart = 0;         // the energy drift is relative to the energy at this sample (once the input doesn't add any)
+        std::function<bool (Dynamic1DWave&)> exercised; // if set, has to be true for at least one sample (otherwise the path wasn't tested)
+    };
+    
+    struct Result
+    {
+        String name;
+        double maxAbsError, energyDrift, referenceEnergyDrift;
+        bool passed;
+    };
+    
+    KernelComparison (double fs, double L = 1);
+    
+    void addPath (const CandidatePath& path) { paths.push_back (path); };
+    void setTrajectory (const std::vector<double>& cVecToUse) { cVec = cVecToUse; };
+    
+    // compares all paths, returns true if all of them passed
+    bool run() override;
+    
+    // Checks the reference against the golden trace, runs the checkpoint, theta bounds, string network and waveguide checks and compares all paths. Returns true if everything passed.
+    bool runAll (const std::string& goldenTraceFile);
+    
+    // (Over)writes the golden trace with the output of the reference. Only do this when a change of the output is intended.
+    bool writeGoldenTrace (const std::string& goldenTraceFile);
+    
+    const std::vector<Result>& getResults() const { return results; };
+    
+    // all optimised paths that are currently available
+    std::vector<CandidatePath> getDefaultPaths();
+    
+private:
+    bool checkGoldenTrace (const std::string& goldenTraceFile);
+    
+    double goldenTolerance = 1e-9;
+    
+    std::vector<CandidatePath> paths;
+    std::vector<Result> results;
+    std::vector<std::unique_ptr<KernelCheck>> checks; // one per feature
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KernelComparison)
+};
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    StringNetworkCheck.cpp
+    Created: 19 Oct 2026 12:12:30pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "StringNetworkCheck.h"
+
+bool StringNetworkCheck::run()
+{
+    const double k = 1.0 / fs;
+    NamedValueSet parameters;
+    parameters.set ("c", cVec[0]);
+    parameters.set ("L", L);
+    
+    // the network solves the junction of the string itself instead of displacementCorrection
+    std::unique_ptr<Dynamic1DWave> reference = createWave (cVec[0]);
+    StringNetwork single (k);
+    single.addString (parameters);
+    
+    double maxAbsError = 0;
+    for (size_t n = 0; n < cVec.size(); ++n)
+    {
+        double refOut = step (*reference, cVec[n]);
+        single.getString (0).changeWavespeed (cVec[n]);
+        single.calculate();
+        single.updateStates();
+        maxAbsError = std::max (maxAbsError, std::abs (single.getOutput (outputRatio) - refOut));
+    }
+    const bool equivalent = maxAbsError <= 1e-12;
+    std::cout << "string network (one string): max abs error " << maxAbsError << (equivalent ? "" : " FAILED") << std::endl;
+    
+    // three strings connected by a spring, a stiffer spring on neighbouring points and a damper, all sweeping up
+    const double cStart[3] = { 310, 400, 523 };
+    double maxGrowth[2] = { 0, 0 };
+    for (int connected = 0; connected < 2; ++connected)
+    {
+        StringNetwork network (k);
+        for (double c : cStart)
+        {
+            parameters.set ("c", c);
+            network.addString (parameters);
+        }
+        if (connected)
+        {
+            network.addConnection (0, 0.3, 1, 0.6, 1e6, 10);
+            network.addConnection (1, 0.61, 2, 0.25, 1e7, 0);
+            network.addConnection (0, 0.8, 2, 0.9, 0, 5);
+        }
+        
+        auto getEnergy = [&] () { double energy = 0; for (int s = 0; s < network.getNumStrings(); ++s) energy += network.getString (s).getEnergy(); return energy; };
+        const double energy0 = getEnergy();
+        const size_t numSamples = static_cast<size_t> (fs * 0.5);
+        for (size_t n = 0; n < numSamples; ++n)
+        {
+            for (int s = 0; s < network.getNumStrings(); ++s)
+                network.getString (s).changeWavespeed (cStart[s] * (1.0 + 0.5 * n / numSamples));
+            network.calculate();
+            network.updateStates();
+            if (n % energyInterval == 0)
+                maxGrowth[connected] = std::max (maxGrowth[connected], getEnergy() / energy0);
+        }
+    }
+    
+    // the springs store some energy, but can't add any (also catches NaNs)
+    const bool stable = maxGrowth[1] <= 1.5 * maxGrowth[0];
+    std::cout << "string network (three strings): energy growth " << maxGrowth[1] << " (unconnected " << maxGrowth[0] << ")" << (stable ? "" : " FAILED") << std::endl;
+    
+    // a chain of strings, every string connected to the next
+    StringNetwork chain (k);
+    for (int s = 0; s < numNetworkStrings; ++s)
+    {
+        parameters.set ("c", 300.0 + 10.0 * s);
+        chain.addString (parameters);
+    }
+    for (int s = 0; s + 1 < numNetworkStrings; ++s)
+        chain.addConnection (s, 0.7, s + 1, 0.3, 1e6, 1);
+    
+    const double startTime = Time::getMillisecondCounterHiRes();
+    for (size_t n = 0; n < cVec.size(); ++n)
+    {
+        chain.calculate();
+        chain.updateStates();
+    }
+    const double seconds = (Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    
+    // the network has to run in real time, which only says something with optimisations on
+   #if JUCE_DEBUG
+    const bool realTime = true;
+    const String timing = " (debug build, not checked)";
+   #else
+    const bool realTime = seconds < cVec.size() / fs;
+    const String timing = realTime ? "" : " slower than real time FAILED";
+   #endif
+    std::cout << "string network (" << numNetworkStrings << " strings): " << seconds << " s for " << cVec.size() / fs << " s of audio" << timing << std::endl;
+    
+    return equivalent && stable && realTime;
+}
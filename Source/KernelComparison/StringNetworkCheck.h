@@ -0,0 +1,34 @@
+/*
+  ==============================================================================
+
+    StringNetworkCheck.h
+    Created: 19 Oct 2026 12:12:30pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "KernelCheck.h"
+#include "../StringNetwork.h"
+
+//==============================================================================
+/*
+    A network of one string should be the string itself, the energy of
+    connected strings shouldn't grow more than that of the same strings
+    unconnected, and a network of numNetworkStrings has to run in real time
+    (in a release build).
+*/
+class StringNetworkCheck : public KernelCheck
+{
+public:
+    StringNetworkCheck (double fs, double L = 1) : KernelCheck (fs, L) {};
+    
+    bool run() override;
+    
+private:
+    int numNetworkStrings = 48;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StringNetworkCheck)
+};
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    ThetaBoundsCheck.cpp
+    Created: 19 Oct 2026 12:11:02pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "ThetaBoundsCheck.h"
+
+bool ThetaBoundsCheck::run()
+{
+    bool passed = true;
+    for (double gridScaling : { 0.5, 1.0, 1.5, 2.0, 3.0 })
+    {
+        // lambdaSq * (1 - 4 theta) <= 1 for stability and -theta * lambdaSq <= 1/12 for the solver
+        const double minTheta = std::max ((1.0 - gridScaling * gridScaling) / 4.0, -gridScaling * gridScaling / 12.0);
+        const double cStart = std::max (294.0, 1.01 * L * fs / (Global::maxN * gridScaling));
+        const std::vector<double> trajectory = Global::linspace (cStart, 2.0 * cStart, fs * 0.5);
+        
+        // the energy of the string grows with c, so the bound is relative to that of the explicit scheme
+        std::unique_ptr<Dynamic1DWave> reference = createWave (cStart);
+        const double refEnergy0 = reference->getEnergy();
+        double refGrowth = 0;
+        for (size_t n = 0; n < trajectory.size(); ++n)
+        {
+            step (*reference, trajectory[n]);
+            if (n % energyInterval == 0)
+                refGrowth = std::max (refGrowth, reference->getEnergy() / refEnergy0);
+        }
+        
+        std::vector<double> thetas { minTheta };
+        const double recommendedTheta = gridScaling >= 1.0 ? Dynamic1DWave::getOptimalTheta (gridScaling) : 0.25;
+        if (recommendedTheta != minTheta)
+            thetas.push_back (recommendedTheta);
+        
+        for (double theta : thetas)
+        {
+            std::unique_ptr<Dynamic1DWave> candidate = createWave (cStart, gridScaling);
+            const bool rejectsBeyond = !candidate->setTheta (minTheta - 1e-3) && candidate->getTheta() == 0;
+            const bool accepts = candidate->setTheta (theta);
+            
+            const double energy0 = candidate->getEnergy();
+            double growth = 0;
+            for (size_t n = 0; n < trajectory.size(); ++n)
+            {
+                step (*candidate, trajectory[n]);
+                if (n % energyInterval == 0)
+                    growth = std::max (growth, candidate->getEnergy() / energy0);
+            }
+            
+            // also catches NaNs
+            const bool bounded = growth <= 2.0 * refGrowth;
+            std::cout << "theta " << theta << " (gridScaling " << gridScaling << "): energy growth " << growth << " (reference " << refGrowth << ")"
+                      << (accepts ? "" : ", rejected") << (rejectsBeyond ? "" : ", accepts an unstable theta")
+                      << (accepts && rejectsBeyond && bounded ? "" : " FAILED") << std::endl;
+            passed = passed && accepts && rejectsBeyond && bounded;
+        }
+    }
+    return passed;
+}
@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    ThetaBoundsCheck.h
+    Created: 19 Oct 2026 12:11:02pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "KernelCheck.h"
+
+//==============================================================================
+/*
+    Checks that setTheta() accepts theta up to the stability bound (and not
+    beyond) for several grid scalings, and that the energy of a string at the
+    bound stays bounded during a sweep.
+*/
+class ThetaBoundsCheck : public KernelCheck
+{
+public:
+    ThetaBoundsCheck (double fs, double L = 1) : KernelCheck (fs, L) {};
+    
+    bool run() override;
+    
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ThetaBoundsCheck)
+};
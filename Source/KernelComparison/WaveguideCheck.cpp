@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    WaveguideCheck.cpp
+    Created: 19 Oct 2026 12:13:51pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "WaveguideCheck.h"
+
+bool WaveguideCheck::run()
+{
+    // c = 294 gives N = 150
+    const double c = 294;
+    const size_t exciteSample = static_cast<size_t> (fs * 0.1);
+    std::unique_ptr<Dynamic1DWave> reference = createWave (c);
+    NamedValueSet parameters;
+    parameters.set ("c", c);
+    parameters.set ("L", L);
+    DigitalWaveguide waveguide (parameters, 1.0 / fs);
+    
+    const double energy0 = waveguide.getEnergy();
+    double maxAbsError = 0, energyDrift = std::abs (energy0 - reference->getEnergy()) / energy0;
+    for (size_t n = 0; n < static_cast<size_t> (fs * 0.25); ++n)
+    {
+        if (n == exciteSample)
+        {
+            reference->excite();
+            waveguide.excite();
+        }
+        maxAbsError = std::max (maxAbsError, std::abs (step (waveguide, c) - step (*reference, c)));
+        if (n < exciteSample && n % energyInterval == 0)
+            energyDrift = std::max (energyDrift, std::abs (waveguide.getEnergy() - energy0) / energy0);
+    }
+    
+    // also catches NaNs
+    bool passed = maxAbsError <= tolerance && energyDrift <= tolerance;
+    std::cout << "digital waveguide (c = " << c << "): max abs error " << maxAbsError << ", energy drift " << energyDrift
+              << (passed ? "" : " FAILED") << std::endl;
+    
+    // For a fractional N getEnergy() reads the lower rail in between its samples, which ripples with the high frequencies of
+    // the excitation, so the mean energy over the first and last tenth of a second is compared instead.
+    parameters.set ("c", fractionalWavespeed);
+    DigitalWaveguide fractionalWaveguide (parameters, 1.0 / fs);
+    const size_t numSamples = static_cast<size_t> (fs);
+    const size_t windowLength = numSamples / 10;
+    double firstEnergy = 0, lastEnergy = 0;
+    for (size_t n = 0; n < numSamples; ++n)
+    {
+        step (fractionalWaveguide, fractionalWavespeed);
+        if (n % energyInterval == 0 && n < windowLength)
+            firstEnergy += fractionalWaveguide.getEnergy();
+        else if (n % energyInterval == 0 && n >= numSamples - windowLength)
+            lastEnergy += fractionalWaveguide.getEnergy();
+    }
+    const double fractionalEnergyDrift = std::abs (lastEnergy - firstEnergy) / firstEnergy;
+    const bool fractionalPassed = fractionalEnergyDrift <= energyTolerance;
+    std::cout << "digital waveguide (c = " << fractionalWavespeed << "): energy drift " << fractionalEnergyDrift
+              << " in " << numSamples / fs << " s" << (fractionalPassed ? "" : " FAILED") << std::endl;
+    
+    return passed && fractionalPassed;
+}
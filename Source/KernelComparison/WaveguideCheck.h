@@ -0,0 +1,34 @@
+/*
+  ==============================================================================
+
+    WaveguideCheck.h
+    Created: 19 Oct 2026 12:13:51pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "KernelCheck.h"
+#include "../DigitalWaveguide.h"
+
+//==============================================================================
+/*
+    For an integer N the waveguide should be the grid (also after exciting it
+    again) and conserve its energy, for a fractional N (at
+    fractionalWavespeed) its mean energy shouldn't drift.
+*/
+class WaveguideCheck : public KernelCheck
+{
+public:
+    WaveguideCheck (double fs, double L = 1) : KernelCheck (fs, L) {};
+    
+    bool run() override;
+    
+private:
+    double tolerance = 1e-9;
+    double energyTolerance = 1e-3; // a third-order Lagrange interpolation in the loop lost 70% in 1 s at c = 310
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveguideCheck)
+};
@@ -8,6 +8,9 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "KernelComparison/KernelComparison.h"
+#include "ParameterSweep.h"
+#include "SessionJournal.h"
 
 //==============================================================================
 class InteractiveDynamicGridApplication  : public juce::JUCEApplication
@@ -25,7 +28,55 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
-        mainWindow.reset (new MainWindow (getApplicationName()));
+        // Headless comparison of the optimised paths against the reference implementation:
+        // --compare-kernels [goldenTrace.csv] [--regenerate-golden]
+        // (the golden trace defaults to the one next to KernelComparison, relative to the project folder)
+        StringArray args = StringArray::fromTokens (commandLine, true);
+        int compareIdx = args.indexOf ("--compare-kernels");
+        if (compareIdx >= 0)
+        {
+            bool regenerate = args.contains ("--regenerate-golden");
+            args.removeString ("--regenerate-golden");
+            File goldenTraceFile = File::getCurrentWorkingDirectory().getChildFile (compareIdx + 1 < args.size() ? args[compareIdx + 1].unquoted() : "Source/KernelComparison/goldenTrace.csv");
+            
+            KernelComparison kernelComparison (44100.0);
+            bool passed = regenerate ? kernelComparison.writeGoldenTrace (goldenTraceFile.getFullPathName().toStdString())
+                                     : kernelComparison.runAll (goldenTraceFile.getFullPathName().toStdString());
+            setApplicationReturnValue (passed ? 0 : 1);
+            quit();
+            return;
+        }
+        
+        // Headless parameter sweep: --sweep spec.json [summary.csv]
+        int sweepIdx = args.indexOf ("--sweep");
+        if (sweepIdx >= 0 && sweepIdx + 1 < args.size())
+        {
+            File specFile (File::getCurrentWorkingDirectory().getChildFile (args[sweepIdx + 1].unquoted()));
+            String summaryFile = sweepIdx + 2 < args.size() ? args[sweepIdx + 2].unquoted() : "sweepSummary.csv";
+            
+            ParameterSweep parameterSweep (JSON::parse (specFile));
+            std::cout << "Simulating " << parameterSweep.getNumConfigurations() << " configurations (" << parameterSweep.getNumSkipped() << " skipped)" << std::endl;
+            parameterSweep.run();
+            setApplicationReturnValue (parameterSweep.writeSummary (summaryFile.toStdString()) ? 0 : 1);
+            quit();
+            return;
+        }
+        
+        // Headless replay of a recorded session: --replay session.journal [output.wav]
+        int replayIdx = args.indexOf ("--replay");
+        if (replayIdx >= 0 && replayIdx + 1 < args.size())
+        {
+            File journalFile (File::getCurrentWorkingDirectory().getChildFile (args[replayIdx + 1].unquoted()));
+            String wavFile = replayIdx + 2 < args.size() ? File::getCurrentWorkingDirectory().getChildFile (args[replayIdx + 2].unquoted()).getFullPathName() : String();
+            
+            bool bitExact = SessionJournal::replay (journalFile.getFullPathName().toStdString(), wavFile.toStdString());
+            setApplicationReturnValue (bitExact ? 0 : 1);
+            quit();
+            return;
+        }
+        
+        // --record writes a journal of the session (to the documents folder) that can be replayed with --replay
+        mainWindow.reset (new MainWindow (getApplicationName(), args.contains ("--record")));
     }
 
     void shutdown() override
@@ -58,14 +109,14 @@ public:
     class MainWindow    : public juce::DocumentWindow
     {
     public:
-        MainWindow (juce::String name)
+        MainWindow (juce::String name, bool recordJournal)
             : DocumentWindow (name,
                               juce::Desktop::getInstance().getDefaultLookAndFeel()
                                                           .findColour (juce::ResizableWindow::backgroundColourId),
                               DocumentWindow::allButtons)
         {
             setUsingNativeTitleBar (true);
-            setContentOwned (new MainComponent(), true);
+            setContentOwned (new MainComponent (recordJournal), true);
 
            #if JUCE_IOS || JUCE_ANDROID
             setFullScreen (true);
@@ -1,7 +1,7 @@
 #include "MainComponent.h"
 
 //==============================================================================
-MainComponent::MainComponent()
+MainComponent::MainComponent (bool recordJournal) : recordJournal (recordJournal)
 {
     // Make sure you set the size of the component after
     // you add any child components.
@@ -11,13 +11,16 @@ MainComponent::MainComponent()
         && ! juce::RuntimePermissions::isGranted (juce::RuntimePermissions::recordAudio))
     {
         juce::RuntimePermissions::request (juce::RuntimePermissions::recordAudio,
-                                           [&] (bool granted) { setAudioChannels (granted ? 2 : 0, 2); });
+                                           [&] (bool granted) { numInputChannels.store (granted ? 2 : 0); setAudioChannels (numInputChannels.load(), 2); });
     }
     else
     {
         // Specify the number of input and output channels that we want to open
-        setAudioChannels (2, 2);
+        setAudioChannels (numInputChannels.load(), 2);
     }
+    
+    resonatorButton.onClick = [this] { resonatorMode.store (resonatorButton.getToggleState()); };
+    resonatorButton.setEnabled (!Global::useWaveguide);
 }
 
 MainComponent::~MainComponent()
@@ -43,12 +46,66 @@ void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRat
     if (Global::useCVec)
         cVec = Global::linspace(294, 588, fs);
     
+    // the message thread only reads the atomics of the analyser, so it is never recreated
+    pitchAnalyser.stopAnalysis();
+    pitchAnalyser.prepare (fs);
+    pitchAnalyser.startAnalysis();
+    
     NamedValueSet parameters;
     parameters.set ("c", Global::useCVec ? cVec[0] : 600);
     parameters.set ("L", 1);
+    parameters.set ("gridScaling", Global::gridScaling);
     
     dynamic1DWave = std::make_unique<Dynamic1DWave>(parameters, 1.0 / fs);
-    double test = static_cast<double>(*parameters.getVarPointer("L")) * fs / (Global::maxN);
+    dynamic1DWave->setTheta (Global::theta);
+    dynamic1DWave->setIdleDetection (true);
+    dynamic1DWave->setModalSynthesis (Global::useModalSynthesis);
+    if (Global::useModalSynthesis)
+        dynamic1DWave->setBackgroundModalDecomposition (true);
+    dynamic1DWave->addMouseListener (this, false);
+    if (Global::useWaveguide)
+    {
+        digitalWaveguide = std::make_unique<DigitalWaveguide> (parameters, 1.0 / fs);
+        vibratingString = digitalWaveguide.get();
+    }
+    else
+    {
+        vibratingString = dynamic1DWave.get();
+    }
+    resonatorModeApplied = false; // the new string starts with modal synthesis (if it is used)
+    stabilityWatchdog.prepare (fs, samplesPerBlockExpected);
+    
+    if (recordJournal)
+    {
+        // one file per session, so that a restart doesn't overwrite the session to replay
+        File journalFile = File::getSpecialLocation (File::userDocumentsDirectory)
+            .getChildFile ("InteractiveDynamicGrid " + Time::getCurrentTime().formatted ("%Y-%m-%d %H-%M-%S") + ".journal")
+            .getNonexistentSibling();
+        std::cout << "Recording the session to " << journalFile.getFullPathName() << std::endl;
+        sessionJournal = std::make_unique<SessionJournal> (journalFile.getFullPathName().toStdString());
+        journalInput.resize (std::max (1, samplesPerBlockExpected), 0);
+        numJournalInput = 0;
+        journalStart = n;
+        journalWavespeed = *parameters.getVarPointer ("c");
+        
+        journal (SessionJournal::sampleRate, fs);
+        journal (SessionJournal::blockSize, samplesPerBlockExpected);
+        journal (SessionJournal::length, *parameters.getVarPointer ("L"));
+        journal (SessionJournal::initialWavespeed, journalWavespeed);
+        journal (SessionJournal::gridScaling, Global::gridScaling);
+        journal (SessionJournal::theta, Global::theta);
+        journal (SessionJournal::idleDetection, 1);
+        journal (SessionJournal::modalSynthesis, Global::useModalSynthesis);
+        journal (SessionJournal::useWaveguide, Global::useWaveguide);
+        journal (SessionJournal::outputRatio, outputRatio);
+        for (double ratio : Global::injectionRatios)
+            journal (SessionJournal::injectionRatio, ratio);
+        journal (SessionJournal::inputGain, Global::inputGain);
+        journal (SessionJournal::stabilityWatchdog, Global::useStabilityWatchdog);
+        sessionJournal->startRecording();
+    }
+    
+    double test = static_cast<double>(*parameters.getVarPointer("L")) * fs / (Global::maxN * Global::gridScaling);
     waveSpeedSlider.setRange (test, 2000.0);
     waveSpeedSlider.setValue (*parameters.getVarPointer("c"));
     waveSpeedSlider.addListener (this);
@@ -57,6 +114,8 @@ void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRat
     setSize (800, 600);
     
     addAndMakeVisible (waveSpeedSlider);
+    addAndMakeVisible (pitchLabel);
+    addAndMakeVisible (resonatorButton);
     addAndMakeVisible (dynamic1DWave.get());
 
 
@@ -68,11 +127,30 @@ void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& buffe
 
     // For more details, see the help for AudioProcessor::getNextAudioBlock()
 
-    // Right now we are not producing any data, in which case we need to clear the buffer
-    // (to prevent the output of random noise)
-    bufferToFill.clearActiveBufferRegion();
+    // In resonator mode the input is read straight from the buffer. Every input sample is
+    // read before the output sample at the same index overwrites it, so nothing is copied.
+    // Forces can only be applied to the grid.
+    const int numInputs = numInputChannels.load();
+    const bool useInput = resonatorMode.load() && numInputs > 0 && !Global::useWaveguide;
+    if (useInput != resonatorModeApplied)
+    {
+        dynamic1DWave->setModalSynthesis (Global::useModalSynthesis && !useInput);
+        resonatorModeApplied = useInput;
+        journal (SessionJournal::resonatorMode, useInput);
+    }
+    
+    if (exciteRequested.exchange (false))
+    {
+        vibratingString->excite();
+        stabilityWatchdog.notifyExcitation();
+        journal (SessionJournal::excite, 1);
+    }
+    
+    // Otherwise we need to clear the buffer (to prevent the output of random noise)
+    if (!useInput)
+        bufferToFill.clearActiveBufferRegion();
     
-    // Get pointers to output locations
+    // Get pointers to output locations (which hold the input in resonator mode)
     float* const channelData1 = bufferToFill.buffer->getWritePointer (0, bufferToFill.startSample);
     float* const channelData2 = bufferToFill.buffer->getWritePointer (1, bufferToFill.startSample);
     
@@ -83,12 +161,30 @@ void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& buffe
     
     for (int i = 0; i < bufferToFill.numSamples; ++i)
     {
-
         if (Global::useCVec && n < cVec.size())
-            dynamic1DWave->changeWavespeed(cVec[n]);
+            vibratingString->changeWavespeed(cVec[n]);
+        
+        vibratingString->updateParams();
+        if (vibratingString->getWavespeed() != journalWavespeed)
+        {
+            journalWavespeed = vibratingString->getWavespeed();
+            journal (SessionJournal::wavespeed, journalWavespeed);
+        }
+        const bool wasModal = dynamic1DWave->isModalActive();
+        vibratingString->calculate();
+        
+        // the decomposition finishes at a time that depends on the machine, so the switch is an input of the session
+        if (!wasModal && dynamic1DWave->isModalActive())
+            journal (SessionJournal::modalSwitch, 1);
         
-        dynamic1DWave->updateParams();
-        dynamic1DWave->calculate();
+        if (useInput)
+        {
+            float input = numInputs > 1 ? 0.5f * (channelData1[i] + channelData2[i]) : channelData1[i];
+            if (sessionJournal != nullptr)
+                journalInput[numJournalInput++] = input;
+            for (double ratio : Global::injectionRatios)
+                dynamic1DWave->addForceAt (ratio, Global::inputGain * input);
+        }
 //        if (n < 22050)
 //        {
 //            dynamic1DWave->saveToFiles();
@@ -98,18 +194,42 @@ void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& buffe
 //            std::cout << "done" << std::endl;
 //            dynamic1DWave->closeFiles();
 //        }
-        dynamic1DWave->updateStates();
+        vibratingString->updateStates();
         
-        output = dynamic1DWave->getOutput (0.2); // get output at 0.8L of the string
+        output = vibratingString->getOutput (outputRatio); // get output at 0.8L of the string
 //        std::cout << output << std::endl;
         channelData1[i] = limit (output);
         channelData2[i] = limit (output);
         
         ++n;
+        if (numJournalInput == static_cast<int> (journalInput.size()))
+            flushJournalInput();
     }
+    flushJournalInput();
+    
+    // the grid is checked once per block (the waveguide is stable by construction)
+    if (Global::useStabilityWatchdog && !Global::useWaveguide)
+        stabilityWatchdog.check (*dynamic1DWave);
+    
+    // the analysis itself happens on a background thread
+    pitchAnalyser.setExpectedFrequency (vibratingString->getWavespeed() / (2.0 * vibratingString->getLength()));
+    pitchAnalyser.pushSamples (channelData1, bufferToFill.numSamples);
+    
+    if (sessionJournal != nullptr)
+        journal (SessionJournal::outputChecksum, SessionJournal::hashToValue (SessionJournal::hashSamples (SessionJournal::hashStart, channelData1, bufferToFill.numSamples)));
 }
 
 
+void MainComponent::flushJournalInput()
+{
+    if (numJournalInput == 0)
+        return;
+    
+    // the input samples are the last numJournalInput samples before n
+    sessionJournal->recordInput (n - journalStart - numJournalInput, journalInput.data(), numJournalInput);
+    numJournalInput = 0;
+}
+
 void MainComponent::releaseResources()
 {
     // This will be called when the audio device stops, or when it is being
@@ -134,6 +254,9 @@ void MainComponent::resized()
     // update their positions.
     Rectangle<int> totArea = getLocalBounds();
     waveSpeedSlider.setBounds (totArea.removeFromBottom(Global::sliderHeight));
+    Rectangle<int> topArea = totArea.removeFromTop(Global::sliderHeight);
+    resonatorButton.setBounds (topArea.removeFromRight(100));
+    pitchLabel.setBounds (topArea);
     dynamic1DWave->setBounds (totArea);
 }
 
@@ -155,11 +278,37 @@ double MainComponent::limit (double val)
 
 void MainComponent::timerCallback()
 {
+    String watchdogText;
+    if (Global::useStabilityWatchdog)
+    {
+        int numResets = stabilityWatchdog.getNumResets();
+        int numDamped = stabilityWatchdog.getNumDamped();
+        if (numResets != numResetsReported || numDamped != numDampedReported)
+        {
+            std::cout << "Unstable string: reset " << numResets << " times, damped " << numDamped << " times" << std::endl;
+            numResetsReported = numResets;
+            numDampedReported = numDamped;
+        }
+        if (numResets + numDamped > 0)
+            watchdogText = ", unstable: " + String (numResets) + " resets, " + String (numDamped) + " damped";
+    }
+    
+    pitchLabel.setText ("f0: " + String (pitchAnalyser.getF0(), 2) + " Hz (c / 2L: " + String (pitchAnalyser.getExpectedF0(), 2)
+                        + " Hz, deviation: " + String (pitchAnalyser.getDeviationInCents(), 1) + " cents)" + watchdogText, dontSendNotification);
+    dynamic1DWave->updateVisualisation();
     repaint();
 }
 
 void MainComponent::sliderValueChanged (Slider* slider)
 {
     if (slider == &waveSpeedSlider && !Global::useCVec)
-        dynamic1DWave->changeWavespeed (slider->getValue());
+    {
+        vibratingString->changeWavespeed (slider->getValue());
+    }
+}
+
+void MainComponent::mouseDown (const MouseEvent& e)
+{
+    if (e.eventComponent == dynamic1DWave.get())
+        exciteRequested.store (true);
 }
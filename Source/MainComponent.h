@@ -2,6 +2,10 @@
 
 #include <JuceHeader.h>
 #include "Dynamic1DWave.h"
+#include "DigitalWaveguide.h"
+#include "PitchAnalyser.h"
+#include "SessionJournal.h"
+#include "StabilityWatchdog.h"
 #include "Global.h"
 //==============================================================================
 /*
@@ -12,7 +16,7 @@ class MainComponent  : public juce::AudioAppComponent, public Timer, public Slid
 {
 public:
     //==============================================================================
-    MainComponent();
+    MainComponent (bool recordJournal = false); // records the inputs of the session so that it can be replayed (--replay)
     ~MainComponent() override;
 
     //==============================================================================
@@ -29,6 +33,8 @@ public:
     void timerCallback() override;
     
     void sliderValueChanged (Slider* slider) override;
+    
+    void mouseDown (const MouseEvent& e) override; // clicking the string excites it
 
 private:
     //==============================================================================
@@ -36,10 +42,39 @@ private:
     double fs;
     unsigned long n = 0;
     std::unique_ptr<Dynamic1DWave> dynamic1DWave;
+    std::unique_ptr<DigitalWaveguide> digitalWaveguide; // only used if Global::useWaveguide is true
+    VibratingString* vibratingString = nullptr; // the one that sounds
     
     std::vector<double> cVec;
     Slider waveSpeedSlider;
     
+    PitchAnalyser pitchAnalyser;
+    Label pitchLabel;
+    
+    // resonator mode: the live input is injected as a force on the string
+    ToggleButton resonatorButton { "Resonator" };
+    std::atomic<bool> resonatorMode { false };
+    bool resonatorModeApplied = false; // audio thread only
+    std::atomic<int> numInputChannels { 2 }; // set on the message thread when the permission is answered
+    
+    double outputRatio = 0.2;
+    std::atomic<bool> exciteRequested { false };
+    
+    StabilityWatchdog stabilityWatchdog; // only checks the string if Global::useStabilityWatchdog is true
+    int numResetsReported = 0, numDampedReported = 0; // message thread only
+    
+    // session journal (sample indices are relative to the last prepareToPlay)
+    const bool recordJournal;
+    std::unique_ptr<SessionJournal> sessionJournal;
+    unsigned long journalStart = 0;
+    double journalWavespeed = 0; // audio thread only
+    void journal (SessionJournal::EventType type, double value) { if (sessionJournal != nullptr) sessionJournal->record (n - journalStart, type, value); };
+    
+    // the input in resonator mode is journalled per block (or per journalInput.size() samples if a block is longer)
+    std::vector<float> journalInput;
+    int numJournalInput = 0; // audio thread only
+    void flushJournalInput();
+    
 //    std::vector<std::shared_ptr<std::ofstream>> files;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
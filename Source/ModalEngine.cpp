@@ -0,0 +1,299 @@
+/*
+  ==============================================================================
+
+    ModalEngine.cpp
+    Created: 19 Oct 2026 2:05:17pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "ModalEngine.h"
+
+ModalEngine::ModalEngine() : Thread ("ModalEngine")
+{
+    for (int n = 0; n < 2; ++n)
+    {
+        qReal[n] = nullptr;
+        qImag[n] = nullptr;
+    }
+}
+
+ModalEngine::~ModalEngine()
+{
+    // a decomposition takes well under a second
+    stopThread (5000);
+}
+
+void ModalEngine::prepare (int maxStateSizeToUse)
+{
+    if (maxStateSize != 0)
+        return;
+
+    maxStateSize = maxStateSizeToUse;
+    decompositions[0].eigen = std::make_unique<EigenDecomposition> (maxStateSize);
+    if (background)
+        allocateBackgroundDecomposition();
+
+    activeModes.resize (maxStateSize, 0);
+    poleReal.resize (maxStateSize, 0);
+    poleImag.resize (maxStateSize, 0);
+    for (auto& modeState : modeStates)
+        modeState.resize (maxStateSize, 0);
+    for (int n = 0; n < 2; ++n)
+    {
+        qReal[n] = modeStates[n].data();
+        qImag[n] = modeStates[n + 2].data();
+    }
+    outputWeightsReal.resize (maxStateSize, 0);
+    outputWeightsImag.resize (maxStateSize, 0);
+
+    coordinates.resize (maxStateSize, 0);
+}
+
+void ModalEngine::allocateBackgroundDecomposition()
+{
+    if (decompositions[1].eigen == nullptr)
+        decompositions[1].eigen = std::make_unique<EigenDecomposition> (maxStateSize);
+    pending = active == &decompositions[0] ? &decompositions[1] : &decompositions[0];
+}
+
+void ModalEngine::setBackgroundDecomposition (bool backgroundToSet)
+{
+    background = backgroundToSet;
+    if (background)
+    {
+        if (maxStateSize != 0)
+            allocateBackgroundDecomposition();
+        startThread();
+    }
+    else
+    {
+        stopThread (5000);
+        pending = active;
+        pendingState.store (idle, std::memory_order_release);
+    }
+}
+
+double* ModalEngine::beginDecomposition (int size, int64 id)
+{
+    jassert (maxStateSize != 0); // call prepare() first
+
+    if (pendingState.load (std::memory_order_acquire) == queued)
+        return nullptr;
+    if (pending->id == id || active->id == id)
+        return nullptr;
+
+    pending->size = size;
+    pending->id = id;
+    pending->valid = false;
+    pendingState.store (idle, std::memory_order_release);
+    return pending->eigen->getMatrix();
+}
+
+void ModalEngine::decompose()
+{
+    if (background)
+    {
+        pendingState.store (queued, std::memory_order_release);
+        notify();
+        return;
+    }
+
+    pending->valid = pending->eigen->decompose (pending->size);
+    pendingState.store (done, std::memory_order_release);
+}
+
+void ModalEngine::run()
+{
+    while (!threadShouldExit())
+    {
+        wait (-1);
+        if (pendingState.load (std::memory_order_acquire) != queued)
+            continue;
+
+        pending->valid = pending->eigen->decompose (pending->size);
+        pendingState.store (done, std::memory_order_release);
+    }
+}
+
+bool ModalEngine::isReady (int64 id) const
+{
+    if (active->id == id)
+        return active->valid;
+
+    return pendingState.load (std::memory_order_acquire) == done && pending->id == id && pending->valid;
+}
+
+bool ModalEngine::project (const double* state, int64 id)
+{
+    if (!isReady (id))
+        return false;
+
+    if (active->id != id)
+    {
+        std::swap (active, pending);
+        pendingState.store (idle, std::memory_order_release);
+    }
+
+    const EigenDecomposition& eigen = *active->eigen;
+    const int size = active->size;
+    const double* V = eigen.getEigenvectors();
+    eigen.solve (state, coordinates.data());
+
+    // the watchdog doesn't check the energy of the modes, so they may not grow (the grid is unstable then anyway)
+    for (int i = 0; i < size; ++i)
+    {
+        if (eigen.getRealPart (i) * eigen.getRealPart (i) + eigen.getImagPart (i) * eigen.getImagPart (i) > 1.0 + growthTolerance)
+        {
+            active->valid = false;
+            return false;
+        }
+    }
+
+    // the eigenvectors of a non-normal matrix can be badly conditioned, so check that the state comes back from all modes
+    double maxState = 0, maxError = 0;
+    for (int i = 0; i < size; ++i)
+    {
+        const double* row = V + i * size;
+        double value = 0;
+        for (int col = 0; col < size; ++col)
+            value += row[col] * coordinates[col];
+
+        maxState = std::max (maxState, std::abs (state[i]));
+        maxError = std::max (maxError, std::abs (value - state[i]));
+    }
+    if (!(maxError <= reconstructionTolerance * maxState))
+    {
+        active->valid = false;
+        return false;
+    }
+
+    // only keep the modes that are sounding (the columns of V are scaled to a maximum of one)
+    auto getAmplitude = [&] (int col) { return eigen.getImagPart (col) > 0 ? std::sqrt (coordinates[col] * coordinates[col] + coordinates[col + 1] * coordinates[col + 1])
+                                                                          : std::abs (coordinates[col]); };
+    double maxAmp = 0;
+    for (int col = 0; col < size; col += eigen.getImagPart (col) > 0 ? 2 : 1)
+        maxAmp = std::max (maxAmp, getAmplitude (col));
+
+    numModes = 0;
+    for (int col = 0; col < size; col += eigen.getImagPart (col) > 0 ? 2 : 1)
+    {
+        if (getAmplitude (col) <= modeThreshold * maxAmp)
+            continue;
+
+        const bool isPair = eigen.getImagPart (col) > 0;
+        activeModes[numModes] = col;
+        poleReal[numModes] = eigen.getRealPart (col);
+        poleImag[numModes] = isPair ? eigen.getImagPart (col) : 0.0;
+        qReal[1][numModes] = coordinates[col];
+        qImag[1][numModes] = isPair ? coordinates[col + 1] : 0.0;
+        ++numModes;
+    }
+    outputRow = -1;
+    return true;
+}
+
+void ModalEngine::reconstruct (double* state) const
+{
+    const int size = active->size;
+    const double* V = active->eigen->getEigenvectors();
+
+    std::fill (state, state + size, 0);
+    for (int i = 0; i < numModes; ++i)
+    {
+        const double* column = V + activeModes[i];
+        const double real = qReal[1][i];
+        if (poleImag[i] > 0)
+        {
+            const double imag = qImag[1][i];
+            for (int row = 0; row < size; ++row)
+                state[row] += column[row * size] * real + column[row * size + 1] * imag;
+        }
+        else
+        {
+            for (int row = 0; row < size; ++row)
+                state[row] += column[row * size] * real;
+        }
+    }
+}
+
+void ModalEngine::calculate()
+{
+    // q^{n+1} = D q^n, with D the block diagonal matrix of eigenvalues ([a b; -b a] for a pair, b = 0 for a real mode)
+    const double* re = poleReal.data();
+    const double* im = poleImag.data();
+    const double* qr = qReal[1];
+    const double* qi = qImag[1];
+    double* qrNext = qReal[0];
+    double* qiNext = qImag[0];
+
+    for (int i = 0; i < numModes; ++i)
+    {
+        qrNext[i] = re[i] * qr[i] + im[i] * qi[i];
+        qiNext[i] = re[i] * qi[i] - im[i] * qr[i];
+    }
+}
+
+void ModalEngine::updateStates()
+{
+    std::swap (qReal[0], qReal[1]);
+    std::swap (qImag[0], qImag[1]);
+}
+
+double ModalEngine::evaluate (int row) const
+{
+    const double* V = active->eigen->getEigenvectors() + row * active->size;
+
+    double val = 0;
+    for (int i = 0; i < numModes; ++i)
+    {
+        val += V[activeModes[i]] * qReal[1][i];
+        if (poleImag[i] > 0)
+            val += V[activeModes[i] + 1] * qImag[1][i];
+    }
+    return val;
+}
+
+double ModalEngine::evaluateCached (int row)
+{
+    if (row != outputRow)
+    {
+        const double* V = active->eigen->getEigenvectors() + row * active->size;
+        for (int i = 0; i < numModes; ++i)
+        {
+            outputWeightsReal[i] = V[activeModes[i]];
+            outputWeightsImag[i] = poleImag[i] > 0 ? V[activeModes[i] + 1] : 0.0;
+        }
+        outputRow = row;
+    }
+
+    // four independent partial sums so that the loop can be vectorised without reordering a single sum
+    const double* qr = qReal[1];
+    const double* qi = qImag[1];
+    double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+
+    int i = 0;
+    for (; i + 1 < numModes; i += 2)
+    {
+        sum0 += outputWeightsReal[i] * qr[i];
+        sum1 += outputWeightsImag[i] * qi[i];
+        sum2 += outputWeightsReal[i + 1] * qr[i + 1];
+        sum3 += outputWeightsImag[i + 1] * qi[i + 1];
+    }
+    for (; i < numModes; ++i)
+    {
+        sum0 += outputWeightsReal[i] * qr[i];
+        sum1 += outputWeightsImag[i] * qi[i];
+    }
+
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+double ModalEngine::getSumOfSquares() const
+{
+    double sum = 0;
+    for (int i = 0; i < numModes; ++i)
+        sum += qReal[1][i] * qReal[1][i] + qImag[1][i] * qImag[1][i];
+    return sum;
+}
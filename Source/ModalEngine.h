@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    ModalEngine.h
+    Created: 19 Oct 2026 2:05:17pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Global.h"
+#include "EigenDecomposition.h"
+
+//==============================================================================
+/*
+    Modal representation of the grid while its update is constant (static c).
+    One sample of the grid is linear in the state s = (x^n, x^{n-1}), so it can
+    be written as s^{n+1} = A s^n, with A including the interpolation and the
+    displacement correction between u and w (and the implicit scheme or the
+    low-pass connection if they are used). The engine decomposes A into its
+    eigenvectors, so the modes and their frequencies (and damping) are exactly
+    those of the grid and switching back and forth is continuous for any N.
+
+    The decomposition costs O(size^3) and can run on a background thread. The
+    modes within modeThreshold (-80 dB) of the loudest one are packed into
+    contiguous arrays, so that a sample costs four multiplications per mode for
+    the poles and two for the output (the weights of the output row are
+    cached), without branches. An excitation as narrow as the pluck of excite()
+    keeps nearly all modes above that though, so a sample costs about as much
+    as a sample of the grid.
+*/
+class ModalEngine : private Thread
+{
+public:
+    ModalEngine();
+    ~ModalEngine() override;
+
+    void prepare (int maxStateSize); // allocates (once), call before anything else
+
+    // decompose() returns immediately and the result is picked up later. The first call allocates a second
+    // decomposition, as the audio thread keeps using the active one in the meantime.
+    void setBackgroundDecomposition (bool background);
+
+    // Returns the (row major) matrix A to fill in for the update with this id, or nullptr
+    // if this id has been decomposed already or the background thread is still busy
+    double* beginDecomposition (int size, int64 id);
+    void decompose();
+    bool isReady (int64 id) const; // a valid decomposition with this id is available
+
+    // Expresses the state in the modes of decomposition id and keeps the loudest ones. Returns false if it isn't ready, it has
+    // growing modes or the state can't be reconstructed accurately enough (then the id won't be tried again).
+    bool project (const double* state, int64 id);
+    void reconstruct (double* state) const; // state = V q from the kept modes, both time levels of all points
+
+    void calculate();
+    void updateStates();
+
+    // row of the state vector, < 0 for a boundary. The weights of the row are cached, so reading the same row every sample is cheap.
+    double getOutput (int row) { return row < 0 ? 0.0 : evaluateCached (row); };
+    double evaluate (int row) const;
+
+    double getSumOfSquares() const; // of the modal coordinates, not finite if any of them is not
+    int getNumActiveModes() const { return numModes; };
+
+private:
+    void run() override;
+    void allocateBackgroundDecomposition();
+    double evaluateCached (int row);
+
+    struct Decomposition
+    {
+        std::unique_ptr<EigenDecomposition> eigen; // the transition matrix is filled in and decomposed in its memory
+        int size = 0;
+        int64 id = -1;
+        bool valid = false;
+    };
+
+    // without the background thread both point to the first one (the grid doesn't use it while it is being replaced)
+    Decomposition decompositions[2];
+    Decomposition* active = &decompositions[0];
+    Decomposition* pending = &decompositions[0];
+    int maxStateSize = 0;
+
+    enum PendingState { idle, queued, done };
+    std::atomic<int> pendingState { idle };
+    bool background = false;
+
+    // The kept modes, packed: a real eigenvalue has one coordinate (qImag and poleImag are 0), a complex pair two
+    int numModes = 0;
+    std::vector<int> activeModes; // first column of every kept mode
+    std::vector<double> poleReal, poleImag;
+    std::vector<double> modeStates[4];
+    double* qReal[2];
+    double* qImag[2];
+
+    std::vector<double> outputWeightsReal, outputWeightsImag; // of outputRow
+    int outputRow = -1;
+
+    double modeThreshold = 1e-4; // relative to the largest modal amplitude
+    double growthTolerance = 1e-9; // a squared eigenvalue magnitude above 1 + growthTolerance is a growing mode
+    double reconstructionTolerance = 1e-9; // relative to the largest state
+
+    std::vector<double> coordinates;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ModalEngine)
+};
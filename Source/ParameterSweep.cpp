@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    ParameterSweep.cpp
+    Created: 19 Oct 2026 9:31:55am
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "ParameterSweep.h"
+
+ParameterSweep::ParameterSweep (const var& spec)
+{
+    fs = spec.getProperty ("fs", fs);
+    duration = spec.getProperty ("duration", duration);
+    L = spec.getProperty ("L", L);
+    
+    auto getValues = [&spec] (const char* name, double defaultValue) {
+        std::vector<double> values;
+        var val = spec.getProperty (name, var());
+        if (val.isArray())
+        {
+            for (auto& v : *val.getArray())
+                values.push_back (static_cast<double> (v));
+        }
+        else if (!val.isVoid())
+        {
+            values.push_back (static_cast<double> (val));
+        }
+        
+        if (values.empty())
+            values.push_back (defaultValue);
+        return values;
+    };
+    
+    std::vector<double> cStarts = getValues ("cStart", 294);
+    std::vector<double> cEnds = getValues ("cEnd", 588);
+    std::vector<double> lpExponents = getValues ("lpExponent", 10);
+    std::vector<double> useLowPasses = getValues ("useLowPassConnection", 0);
+    std::vector<double> sig0s = getValues ("sig0", 1.0);
+    std::vector<double> etaDivs = getValues ("etaDiv", 1.0);
+    std::vector<double> epsilons = getValues ("epsilon", 0);
+    std::vector<double> gridScalings = getValues ("gridScaling", 1.0);
+    std::vector<double> thetas = getValues ("theta", 0);
+    
+    // all combinations
+    for (double cStart : cStarts)
+        for (double cEnd : cEnds)
+            for (double lpExponent : lpExponents)
+                for (double useLowPass : useLowPasses)
+                    for (double sig0 : sig0s)
+                        for (double etaDiv : etaDivs)
+                            for (double epsilon : epsilons)
+                                for (double gridScaling : gridScalings)
+                                    for (double theta : thetas)
+                                    {
+                                        Configuration config { cStart, cEnd, lpExponent, useLowPass != 0, sig0, etaDiv, epsilon, gridScaling, theta };
+                                        if (isValid (config))
+                                            configurations.push_back (config);
+                                        else
+                                            ++numSkipped;
+                                    }
+}
+
+bool ParameterSweep::isValid (const Configuration& config)
+{
+    const String name = "cStart " + String (config.cStart) + ", cEnd " + String (config.cEnd)
+        + ", gridScaling " + String (config.gridScaling) + ", theta " + String (config.theta);
+    
+    if (L * fs / (config.gridScaling * std::min (config.cStart, config.cEnd)) > Global::maxN)
+    {
+        std::cout << "Skipping " << name << ": more than " << Global::maxN << " points" << std::endl;
+        return false;
+    }
+    if (!Dynamic1DWave::isStableTheta (config.theta, config.gridScaling, true))
+    {
+        std::cout << "Skipping " << name << ": unstable" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ParameterSweep::run()
+{
+    metrics.resize (configurations.size());
+    
+    if (configurations.empty())
+        return;
+    
+    // the last job to finish wakes this thread up
+    std::atomic<int> numRemaining { static_cast<int> (configurations.size()) };
+    WaitableEvent finished;
+    
+    ThreadPool pool (SystemStats::getNumCpus());
+    for (size_t i = 0; i < configurations.size(); ++i)
+    {
+        pool.addJob ([this, i, &numRemaining, &finished] {
+            metrics[i] = simulate (configurations[i]);
+            if (--numRemaining == 0)
+                finished.signal();
+        });
+    }
+    finished.wait();
+}
+
+ParameterSweep::Metrics ParameterSweep::simulate (const Configuration& config)
+{
+    Metrics result { 0, 0, 0 };
+    
+    NamedValueSet parameters;
+    parameters.set ("c", config.cStart);
+    parameters.set ("L", L);
+    parameters.set ("gridScaling", config.gridScaling);
+    
+    Dynamic1DWave wave (parameters, 1.0 / fs);
+    const bool thetaAccepted = wave.setTheta (config.theta);
+    jassert (thetaAccepted); // checked by isValid()
+    ignoreUnused (thetaAccepted);
+    wave.setLowPassConnection (config.useLowPassConnection, config.lpExponent);
+    wave.setDisplacementCorrection (config.sig0, config.etaDiv, config.epsilon);
+    
+    int numSamples = duration * fs;
+    int pitchIntervalSamples = pitchInterval * fs;
+    double energy0 = wave.getEnergy();
+    
+    // only the last pitchWindow samples of the output are kept (and analysed without a hint of the expected frequency)
+    std::vector<double> outputBuffer (pitchWindow, 0);
+    PitchAnalyser pitchAnalyser (pitchWindow);
+    pitchAnalyser.prepare (fs);
+    int writeIdx = 0;
+    
+    for (int n = 0; n < numSamples; ++n)
+    {
+        wave.changeWavespeed (Global::linspace (config.cStart, config.cEnd, numSamples, n));
+        wave.updateParams();
+        wave.calculate();
+        wave.updateStates();
+        
+        outputBuffer[writeIdx] = wave.getOutput (0.2);
+        writeIdx = (writeIdx + 1) % pitchWindow;
+        
+        double energy = wave.getEnergy();
+        if (!std::isfinite (energy))
+        {
+            result.energyDrift = std::numeric_limits<double>::infinity();
+            break;
+        }
+        result.energyDrift = std::max (result.energyDrift, std::abs (energy - energy0) / energy0);
+        result.junctionDiscontinuity = std::max (result.junctionDiscontinuity, wave.getJunctionDiscontinuity());
+        
+        if (n >= pitchWindow && n % pitchIntervalSamples == 0)
+        {
+            // expected frequency in the middle of the window
+            double expectedFreq = Global::linspace (config.cStart, config.cEnd, numSamples, n - pitchWindow / 2) / (2.0 * L);
+            double freq = pitchAnalyser.estimateFrequency (outputBuffer, writeIdx);
+            result.pitchError = std::max (result.pitchError, std::abs (freq - expectedFreq) / expectedFreq);
+        }
+    }
+    return result;
+}
+
+bool ParameterSweep::writeSummary (const std::string& fileName)
+{
+    std::ofstream summary (fileName);
+    if (!summary.is_open())
+    {
+        std::cout << "Could not open " << fileName << std::endl;
+        return false;
+    }
+    
+    summary.precision (8);
+    summary << "cStart, cEnd, lpExponent, useLowPassConnection, sig0, etaDiv, epsilon, gridScaling, theta, energyDrift, pitchError, junctionDiscontinuity;\n";
+    for (size_t i = 0; i < configurations.size() && i < metrics.size(); ++i)
+    {
+        const Configuration& config = configurations[i];
+        const Metrics& metric = metrics[i];
+        summary << config.cStart << ", " << config.cEnd << ", " << config.lpExponent << ", " << config.useLowPassConnection << ", "
+                << config.sig0 << ", " << config.etaDiv << ", " << config.epsilon << ", "
+                << config.gridScaling << ", " << config.theta << ", "
+                << metric.energyDrift << ", " << metric.pitchError << ", " << metric.junctionDiscontinuity << ";\n";
+    }
+    return true;
+}
@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    ParameterSweep.h
+    Created: 19 Oct 2026 9:31:55am
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Dynamic1DWave.h"
+#include "Global.h"
+#include "PitchAnalyser.h"
+
+//==============================================================================
+/*
+    Simulates every combination of the parameters in a sweep specification
+    (a JSON object, see below) headless on all cores and writes one summary
+    table with metrics that are computed while running:
+    - the maximum relative energy drift,
+    - the maximum relative error of the fundamental frequency w.r.t. c / (2L),
+    - the maximum difference between u_M and w_0 (junction discontinuity).
+
+    Every key apart from fs, duration and L holds an array of values:
+    {
+        "fs": 44100, "duration": 1.0, "L": 1,
+        "cStart": [294], "cEnd": [588],
+        "lpExponent": [10], "useLowPassConnection": [0, 1],
+        "sig0": [1], "etaDiv": [1], "epsilon": [0],
+        "gridScaling": [1.5, 2], "theta": [0, -0.1]
+    }
+    Missing keys get the defaults of Dynamic1DWave. Combinations that can't
+    run (theta and gridScaling unstable according to
+    Dynamic1DWave::isStableTheta, or more points than Global::maxN) are
+    skipped with a message and don't appear in the summary.
+*/
+class ParameterSweep
+{
+public:
+    struct Configuration
+    {
+        double cStart, cEnd;
+        double lpExponent;
+        bool useLowPassConnection;
+        double sig0, etaDiv, epsilon;
+        double gridScaling, theta;
+    };
+    
+    struct Metrics
+    {
+        double energyDrift, pitchError, junctionDiscontinuity;
+    };
+    
+    ParameterSweep (const var& spec);
+    
+    int getNumConfigurations() { return static_cast<int> (configurations.size()); }; // excluding the skipped ones
+    int getNumSkipped() { return numSkipped; };
+    
+    void run(); // blocks until all configurations have been simulated
+    bool writeSummary (const std::string& fileName);
+    
+private:
+    Metrics simulate (const Configuration& config);
+    
+    double fs = 44100;
+    double duration = 1;
+    double L = 1;
+    
+    int pitchWindow = 2048;
+    double pitchInterval = 0.1; // seconds between pitch estimates
+    
+    // returns false (and prints why) if the configuration can't be simulated
+    bool isValid (const Configuration& config);
+    
+    std::vector<Configuration> configurations;
+    int numSkipped = 0;
+    std::vector<Metrics> metrics;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterSweep)
+};
@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+    PitchAnalyser.cpp
+    Created: 19 Oct 2026 1:14:22pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "PitchAnalyser.h"
+
+PitchAnalyser::PitchAnalyser (int windowSize, int hopSize) : Thread ("PitchAnalyser"),
+hopSize (hopSize),
+fifo (4 * windowSize)
+{
+    fifoBuffer.resize (fifo.getTotalSize(), 0);
+    window.resize (windowSize, 0);
+    
+    // zero padded to at least twice the window, so that the circular autocorrelation is the linear one
+    const int fftSize = nextPowerOfTwo (2 * windowSize);
+    frame.resize (windowSize, 0);
+    nsdf.resize (windowSize / 2 + 2, 0);
+    keyMaxima.reserve (windowSize / 2);
+    spectrum.resize (fftSize, 0);
+    twiddles.resize (fftSize / 2);
+    for (int i = 0; i < fftSize / 2; ++i)
+        twiddles[i] = std::polar (1.0, -2.0 * double_Pi * i / fftSize);
+}
+
+PitchAnalyser::~PitchAnalyser()
+{
+    stopThread (1000);
+}
+
+void PitchAnalyser::prepare (double sampleRate)
+{
+    jassert (!isThreadRunning());
+    
+    fs = sampleRate;
+    fifo.reset();
+    std::fill (window.begin(), window.end(), 0);
+    writeIdx = 0;
+    samplesSinceAnalysis = 0;
+    numSamplesReceived = 0;
+    f0.store (0);
+}
+
+void PitchAnalyser::pushSamples (const float* samples, int numSamples)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+    
+    if (size1 > 0)
+        memcpy (&fifoBuffer[start1], samples, size1 * sizeof (float));
+    if (size2 > 0)
+        memcpy (&fifoBuffer[start2], samples + size1, size2 * sizeof (float));
+    fifo.finishedWrite (size1 + size2);
+    
+    // the analysis can't keep up
+    if (size1 + size2 < numSamples)
+        numDropped += numSamples - size1 - size2;
+}
+
+void PitchAnalyser::run()
+{
+    while (!threadShouldExit())
+    {
+        processPending();
+        wait (10);
+    }
+}
+
+void PitchAnalyser::processPending()
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+    
+    int windowSize = static_cast<int> (window.size());
+    auto addSample = [&] (float sample) {
+        window[writeIdx] = sample;
+        writeIdx = (writeIdx + 1) % windowSize;
+        ++numSamplesReceived;
+        
+        if (++samplesSinceAnalysis < hopSize || numSamplesReceived < windowSize)
+            return;
+        samplesSinceAnalysis = 0;
+        f0.store (estimateFrequency (window, writeIdx));
+    };
+    
+    for (int i = 0; i < size1; ++i)
+        addSample (fifoBuffer[start1 + i]);
+    for (int i = 0; i < size2; ++i)
+        addSample (fifoBuffer[start2 + i]);
+    
+    fifo.finishedRead (size1 + size2);
+}
+
+double PitchAnalyser::estimateFrequency (const std::vector<double>& buffer, int writeIdx)
+{
+    const int size = static_cast<int> (frame.size());
+    jassert (static_cast<int> (buffer.size()) == size);
+    
+    for (int i = 0; i < size; ++i)
+        frame[i] = buffer[(writeIdx + i) % size]; // oldest sample first
+    
+    // autocorrelation r(tau) = sum_i x_i x_{i + tau} is the inverse transform of the power spectrum
+    std::fill (spectrum.begin(), spectrum.end(), 0);
+    for (int i = 0; i < size; ++i)
+        spectrum[i] = frame[i];
+    fft (false);
+    for (auto& bin : spectrum)
+        bin = std::norm (bin);
+    fft (true);
+    
+    if (!(spectrum[0].real() > 0))
+        return 0;
+    
+    // NSDF n(tau) = 2 r(tau) / m(tau), with m(tau) = sum_i x_i^2 + x_{i + tau}^2 (updated per lag)
+    const int minLag = std::max (2, static_cast<int> (fs / maxFreq));
+    const int maxLag = std::min (size / 2, static_cast<int> (fs / minFreq) + 1);
+    double m = 2.0 * spectrum[0].real();
+    nsdf[0] = 1;
+    for (int lag = 1; lag <= maxLag + 1; ++lag)
+    {
+        m -= frame[lag - 1] * frame[lag - 1] + frame[size - lag] * frame[size - lag];
+        nsdf[lag] = m > 0 ? 2.0 * spectrum[lag].real() / m : 0;
+    }
+    
+    // the maximum of every positive lobe after the first zero crossing is a candidate (a key maximum)
+    keyMaxima.clear();
+    double highest = 0;
+    int lobeMax = -1;
+    bool pastZero = false;
+    for (int lag = 1; lag <= maxLag; ++lag)
+    {
+        if (nsdf[lag] <= 0)
+        {
+            pastZero = true;
+            lobeMax = -1;
+            continue;
+        }
+        if (!pastZero || lag < minLag)
+            continue;
+        if (lobeMax < 0 || nsdf[lag] > nsdf[lobeMax])
+            lobeMax = lag;
+        
+        // a lobe that is cut off by maxLag only counts if it peaked before
+        if ((nsdf[lag + 1] <= 0 || lag == maxLag) && lobeMax < maxLag)
+        {
+            keyMaxima.push_back (lobeMax);
+            highest = std::max (highest, nsdf[lobeMax]);
+        }
+    }
+    
+    // the first one that is close to the highest
+    int firstPeak = -1;
+    for (int lag : keyMaxima)
+    {
+        if (nsdf[lag] >= peakThreshold * highest)
+        {
+            firstPeak = lag;
+            break;
+        }
+    }
+    if (firstPeak < 0)
+        return 0;
+    
+    // parabolic interpolation of the peak
+    const double prev = nsdf[firstPeak - 1], cur = nsdf[firstPeak], next = nsdf[firstPeak + 1];
+    const double denominator = prev - 2.0 * cur + next;
+    const double offset = denominator != 0 ? 0.5 * (prev - next) / denominator : 0;
+    return fs / (firstPeak + offset);
+}
+
+void PitchAnalyser::fft (bool inverse)
+{
+    const int size = static_cast<int> (spectrum.size());
+    
+    // bit reversed order
+    for (int i = 1, j = 0; i < size; ++i)
+    {
+        int bit = size >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap (spectrum[i], spectrum[j]);
+    }
+    
+    // butterflies
+    for (int length = 2; length <= size; length <<= 1)
+    {
+        const int halfLength = length / 2;
+        const int stride = size / length;
+        for (int start = 0; start < size; start += length)
+        {
+            for (int i = 0; i < halfLength; ++i)
+            {
+                const std::complex<double> twiddle = inverse ? std::conj (twiddles[i * stride]) : twiddles[i * stride];
+                const std::complex<double> even = spectrum[start + i];
+                const std::complex<double> odd = spectrum[start + i + halfLength] * twiddle;
+                spectrum[start + i] = even + odd;
+                spectrum[start + i + halfLength] = even - odd;
+            }
+        }
+    }
+    
+    if (inverse)
+        for (auto& bin : spectrum)
+            bin /= size;
+}
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    PitchAnalyser.h
+    Created: 19 Oct 2026 1:14:22pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+
+//==============================================================================
+/*
+    Streaming estimate of the fundamental frequency of the output. The audio
+    thread only copies samples into a lock-free FIFO; the pitch is estimated
+    every hopSize samples on a background thread (or by calling
+    processPending() directly when used headless) and the results are published
+    through atomics.
+
+    The estimate uses the normalised square difference function (NSDF) of
+    McLeod and Wyvill. The autocorrelation comes from the power spectrum of the
+    zero padded window (a radix-2 FFT). The first peak that comes close to the
+    highest one gives the period, so harmonics aren't mistaken for the
+    fundamental. All lags between maxFreq and minFreq (or half the window) are
+    searched, whatever the wave speed.
+*/
+class PitchAnalyser : private Thread
+{
+public:
+    PitchAnalyser (int windowSize = 2048, int hopSize = 512); // allocates everything
+    ~PitchAnalyser() override;
+    
+    // sets the sample rate and starts over, only while the analysis is stopped
+    void prepare (double sampleRate);
+    
+    void startAnalysis() { startThread(); };
+    void stopAnalysis() { stopThread (1000); };
+    
+    // audio thread
+    void pushSamples (const float* samples, int numSamples);
+    void setExpectedFrequency (double freq) { expectedF0.store (freq); };
+    
+    // analyses everything that has been pushed so far (called by the background thread, or manually when headless)
+    void processPending();
+    
+    double getF0() { return f0.load(); };
+    double getExpectedF0() { return expectedF0.load(); };
+    double getDeviationInCents() { double f = f0.load(), e = expectedF0.load(); return f > 0 && e > 0 ? 1200.0 * log2 (f / e) : 0; };
+    int getNumDroppedSamples() { return numDropped.load(); };
+    
+    // Frequency of a ring buffer of windowSize samples (oldest sample at writeIdx), 0 if no period is found
+    double estimateFrequency (const std::vector<double>& buffer, int writeIdx);
+    
+private:
+    void run() override;
+    
+    void fft (bool inverse); // in place on spectrum, the inverse includes the 1 / size
+    
+    double fs = 44100;
+    int hopSize;
+    
+    // audio thread -> analysis
+    AbstractFifo fifo;
+    std::vector<float> fifoBuffer;
+    std::atomic<int> numDropped { 0 };
+    
+    // analysis thread only
+    std::vector<double> window;
+    int writeIdx = 0;
+    int samplesSinceAnalysis = 0;
+    int numSamplesReceived = 0;
+    double minFreq = 20; // limited to fs / (windowSize / 2)
+    double maxFreq = 4000;
+    double peakThreshold = 0.9; // relative to the highest peak of the NSDF
+    
+    // scratch space of estimateFrequency()
+    std::vector<double> frame, nsdf;
+    std::vector<int> keyMaxima;
+    std::vector<std::complex<double>> spectrum, twiddles;
+    
+    std::atomic<double> f0 { 0 };
+    std::atomic<double> expectedF0 { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchAnalyser)
+};
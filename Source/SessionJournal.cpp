@@ -0,0 +1,379 @@
+/*
+  ==============================================================================
+
+    SessionJournal.cpp
+    Created: 19 Oct 2026 3:47:09pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "SessionJournal.h"
+
+SessionJournal::SessionJournal (const std::string& fileName, int fifoSize, int inputFifoSize) : Thread ("SessionJournal"),
+fileName (fileName),
+fifo (fifoSize),
+inputFifo (inputFifoSize)
+{
+    fifoBuffer.resize (fifo.getTotalSize());
+    inputFifoBuffer.resize (inputFifo.getTotalSize(), 0);
+}
+
+SessionJournal::~SessionJournal()
+{
+    stopRecording();
+}
+
+bool SessionJournal::startRecording()
+{
+    journal.open (fileName, std::ios::binary | std::ios::trunc);
+    if (!journal.is_open())
+    {
+        std::cout << "Could not open " << fileName << std::endl;
+        return false;
+    }
+    
+    uint32 header[2] = { journalMagic, journalVersion };
+    journal.write (reinterpret_cast<const char*> (header), sizeof (header));
+    startThread();
+    return true;
+}
+
+void SessionJournal::stopRecording()
+{
+    stopThread (1000);
+    if (!journal.is_open())
+        return;
+    
+    writePending();
+    journal.close();
+    
+    if (numDropped.load() > 0)
+        std::cout << "The journal dropped " << numDropped.load() << " events, a replay will not be exact" << std::endl;
+}
+
+void SessionJournal::record (uint64 sampleIdx, EventType type, double value)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (1, start1, size1, start2, size2);
+    
+    // the writer can't keep up
+    if (size1 + size2 < 1)
+    {
+        ++numDropped;
+        return;
+    }
+    
+    Event& event = fifoBuffer[size1 > 0 ? start1 : start2];
+    event.sampleIdx = sampleIdx;
+    event.type = type;
+    event.reserved = 0;
+    event.value = value;
+    fifo.finishedWrite (1);
+}
+
+void SessionJournal::recordInput (uint64 startSampleIdx, const float* input, int numSamples)
+{
+    if (std::all_of (input, input + numSamples, [] (float sample) { return sample == 0; }))
+        return;
+    
+    // the event and all samples fit or nothing is written (only this thread writes, so the free space can't shrink)
+    if (fifo.getFreeSpace() < 1 || inputFifo.getFreeSpace() < numSamples)
+    {
+        ++numDropped;
+        return;
+    }
+    
+    int start1, size1, start2, size2;
+    inputFifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+    if (size1 > 0)
+        memcpy (&inputFifoBuffer[start1], input, size1 * sizeof (float));
+    if (size2 > 0)
+        memcpy (&inputFifoBuffer[start2], input + size1, size2 * sizeof (float));
+    inputFifo.finishedWrite (size1 + size2);
+    
+    record (startSampleIdx, inputBlock, numSamples);
+}
+
+void SessionJournal::run()
+{
+    while (!threadShouldExit())
+    {
+        writePending();
+        wait (20);
+    }
+}
+
+void SessionJournal::writePending()
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+    
+    auto writeEvent = [this] (const Event& event) {
+        journal.write (reinterpret_cast<const char*> (&event), sizeof (Event));
+        if (event.type != inputBlock)
+            return;
+        
+        // the samples were pushed before the event, so they are all there
+        int inputStart1, inputSize1, inputStart2, inputSize2;
+        inputFifo.prepareToRead (static_cast<int> (event.value), inputStart1, inputSize1, inputStart2, inputSize2);
+        jassert (inputSize1 + inputSize2 == static_cast<int> (event.value));
+        if (inputSize1 > 0)
+            journal.write (reinterpret_cast<const char*> (&inputFifoBuffer[inputStart1]), inputSize1 * sizeof (float));
+        if (inputSize2 > 0)
+            journal.write (reinterpret_cast<const char*> (&inputFifoBuffer[inputStart2]), inputSize2 * sizeof (float));
+        inputFifo.finishedRead (inputSize1 + inputSize2);
+    };
+    
+    for (int i = 0; i < size1; ++i)
+        writeEvent (fifoBuffer[start1 + i]);
+    for (int i = 0; i < size2; ++i)
+        writeEvent (fifoBuffer[start2 + i]);
+    journal.flush();
+    
+    fifo.finishedRead (size1 + size2);
+}
+
+uint64 SessionJournal::hashSamples (uint64 hash, const float* samples, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        uint32 bits;
+        memcpy (&bits, &samples[i], sizeof (uint32));
+        for (int byte = 0; byte < 4; ++byte)
+        {
+            hash ^= (bits >> (8 * byte)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+bool SessionJournal::replay (const std::string& journalFile, const std::string& wavFile)
+{
+    std::ifstream journalIn (journalFile, std::ios::binary);
+    if (!journalIn.is_open())
+    {
+        std::cout << "Could not open " << journalFile << std::endl;
+        return false;
+    }
+    
+    uint32 magic = 0, version = 0;
+    journalIn.read (reinterpret_cast<char*> (&magic), sizeof (uint32));
+    journalIn.read (reinterpret_cast<char*> (&version), sizeof (uint32));
+    if (magic != journalMagic || version != journalVersion)
+    {
+        std::cout << journalFile << " is not a journal of this version" << std::endl;
+        return false;
+    }
+    
+    // the samples of the input blocks are gathered in inputSamples, in the order of their events
+    std::vector<Event> events;
+    std::vector<float> inputSamples;
+    Event event;
+    while (journalIn.read (reinterpret_cast<char*> (&event), sizeof (Event)))
+    {
+        events.push_back (event);
+        if (event.type != inputBlock)
+            continue;
+        
+        const size_t numInputSamples = static_cast<size_t> (event.value);
+        inputSamples.resize (inputSamples.size() + numInputSamples);
+        if (!journalIn.read (reinterpret_cast<char*> (inputSamples.data() + inputSamples.size() - numInputSamples), numInputSamples * sizeof (float)))
+        {
+            std::cout << journalFile << " ends in the middle of an input block" << std::endl;
+            return false;
+        }
+    }
+    
+    // an input block is recorded at the end of its block (with the sample it starts at)
+    std::stable_sort (events.begin(), events.end(), [] (const Event& a, const Event& b) { return a.sampleIdx < b.sampleIdx; });
+    
+    // configuration (defaults as in MainComponent)
+    double fs = 44100, blockSizeToUse = 512, L = 1, c = 600, gridScalingToUse = 1, thetaToUse = 0, outputRatioToUse = 0.2, inputGainToUse = 0;
+    bool idleDetectionToUse = false, modalSynthesisToUse = false, useWaveguideToUse = false, useStabilityWatchdog = false;
+    std::vector<double> injectionRatios;
+    
+    size_t e = 0;
+    for (; e < events.size() && events[e].sampleIdx == 0 && events[e].type <= stabilityWatchdog; ++e)
+    {
+        double value = events[e].value;
+        switch (events[e].type)
+        {
+            case sampleRate:        fs = value; break;
+            case blockSize:         blockSizeToUse = value; break;
+            case length:            L = value; break;
+            case initialWavespeed:  c = value; break;
+            case gridScaling:       gridScalingToUse = value; break;
+            case theta:             thetaToUse = value; break;
+            case idleDetection:     idleDetectionToUse = value != 0; break;
+            case modalSynthesis:    modalSynthesisToUse = value != 0; break;
+            case useWaveguide:      useWaveguideToUse = value != 0; break;
+            case outputRatio:       outputRatioToUse = value; break;
+            case injectionRatio:    injectionRatios.push_back (value); break;
+            case inputGain:         inputGainToUse = value; break;
+            case stabilityWatchdog: useStabilityWatchdog = value != 0; break;
+            default: break;
+        }
+    }
+    
+    NamedValueSet parameters;
+    parameters.set ("c", c);
+    parameters.set ("L", L);
+    parameters.set ("gridScaling", gridScalingToUse);
+    
+    // forces, modes and the watchdog only exist on the grid
+    std::unique_ptr<Dynamic1DWave> dynamic1DWave;
+    std::unique_ptr<DigitalWaveguide> digitalWaveguide;
+    VibratingString* vibratingString;
+    if (useWaveguideToUse)
+    {
+        digitalWaveguide = std::make_unique<DigitalWaveguide> (parameters, 1.0 / fs);
+        vibratingString = digitalWaveguide.get();
+    }
+    else
+    {
+        dynamic1DWave = std::make_unique<Dynamic1DWave> (parameters, 1.0 / fs);
+        dynamic1DWave->setTheta (thetaToUse);
+        dynamic1DWave->setIdleDetection (idleDetectionToUse);
+        dynamic1DWave->setModalSynthesis (modalSynthesisToUse);
+        dynamic1DWave->setAutomaticModalSwitch (false); // the recorded switches decompose synchronously
+        vibratingString = dynamic1DWave.get();
+    }
+    
+    std::unique_ptr<StabilityWatchdog> watchdog;
+    if (useStabilityWatchdog && dynamic1DWave != nullptr)
+    {
+        watchdog = std::make_unique<StabilityWatchdog>();
+        watchdog->prepare (fs, static_cast<int> (blockSizeToUse));
+    }
+    
+    std::unique_ptr<AudioFormatWriter> writer;
+    if (!wavFile.empty())
+    {
+        File outputFile (wavFile);
+        outputFile.deleteFile();
+        std::unique_ptr<FileOutputStream> outputStream (outputFile.createOutputStream());
+        WavAudioFormat wavFormat;
+        if (outputStream != nullptr)
+            writer.reset (wavFormat.createWriterFor (outputStream.get(), fs, 2, 32, {}, 0));
+    
+        if (writer == nullptr)
+        {
+            std::cout << "Could not write " << wavFile << std::endl;
+            return false;
+        }
+        outputStream.release(); // owned by the writer
+    }
+    
+    // same as MainComponent::limit()
+    auto limit = [] (double val) { return val < -1 ? -1.0 : (val > 1 ? 1.0 : val); };
+    
+    
+    std::vector<float> block;
+    int numBlocks = 0, numMismatches = 0;
+    bool useInput = false;
+    
+    // the input block that is playing (the samples after it are zero)
+    const float* blockInput = nullptr;
+    uint64 blockInputStart = 0, blockInputLength = 0;
+    size_t nextInputSample = 0;
+    
+    // the journal ends with the checksum of the last block
+    uint64 numSamples = e < events.size() ? events.back().sampleIdx : 0;
+    
+    for (uint64 n = 0; n < numSamples; ++n)
+    {
+        // apply the events of this sample in the order they were recorded
+        for (; e < events.size() && events[e].sampleIdx == n; ++e)
+        {
+            const Event& cur = events[e];
+            switch (cur.type)
+            {
+                case wavespeed:
+                    vibratingString->changeWavespeed (cur.value);
+                    break;
+                case excite:
+                    vibratingString->excite();
+                    if (watchdog != nullptr)
+                        watchdog->notifyExcitation();
+                    break;
+                case resonatorMode:
+                    useInput = cur.value != 0;
+                    if (dynamic1DWave != nullptr)
+                        dynamic1DWave->setModalSynthesis (modalSynthesisToUse && !useInput);
+                    break;
+                case inputBlock:
+                    blockInput = inputSamples.data() + nextInputSample;
+                    blockInputStart = n;
+                    blockInputLength = static_cast<uint64> (cur.value);
+                    nextInputSample += blockInputLength;
+                    break;
+                case modalSwitch:
+                    if (dynamic1DWave != nullptr)
+                        dynamic1DWave->requestModalSwitch();
+                    break;
+                case outputChecksum:
+                    // the end of a block
+                    if (watchdog != nullptr)
+                        watchdog->check (*dynamic1DWave);
+                    if (!checkBlock (block, cur, writer.get(), numMismatches))
+                        return false;
+                    ++numBlocks;
+                    break;
+                default:
+                    break;
+            }
+        }
+        
+        const float inputSample = blockInput != nullptr && n - blockInputStart < blockInputLength ? blockInput[n - blockInputStart] : 0.0f;
+        
+        // same as MainComponent::getNextAudioBlock()
+        vibratingString->updateParams();
+        vibratingString->calculate();
+        if (useInput && dynamic1DWave != nullptr)
+            for (double ratio : injectionRatios)
+                dynamic1DWave->addForceAt (ratio, inputGainToUse * inputSample);
+        vibratingString->updateStates();
+        const double output = vibratingString->getOutput (outputRatioToUse);
+        block.push_back (static_cast<float> (limit (output)));
+    }
+    
+    // the last block
+    for (; e < events.size(); ++e)
+    {
+        if (events[e].type == outputChecksum)
+        {
+            if (!checkBlock (block, events[e], writer.get(), numMismatches))
+                return false;
+            ++numBlocks;
+        }
+    }
+    
+    std::cout << "Replayed " << numSamples << " samples (" << numSamples / fs << " s), " << numBlocks - numMismatches << " of " << numBlocks << " blocks are bit-exact" << std::endl;
+    return numMismatches == 0;
+}
+
+bool SessionJournal::checkBlock (std::vector<float>& block, const Event& checksum, AudioFormatWriter* writer, int& numMismatches)
+{
+    uint64 recorded;
+    memcpy (&recorded, &checksum.value, sizeof (uint64));
+    if (hashSamples (hashStart, block.data(), static_cast<int> (block.size())) != recorded)
+    {
+        if (numMismatches == 0)
+            std::cout << "First difference in the block ending at sample " << checksum.sampleIdx << std::endl;
+        ++numMismatches;
+    }
+    
+    if (writer != nullptr)
+    {
+        const float* channels[2] = { block.data(), block.data() };
+        if (!writer->writeFromFloatArrays (channels, 2, static_cast<int> (block.size())))
+        {
+            std::cout << "Could not write the output" << std::endl;
+            return false;
+        }
+    }
+    block.clear();
+    return true;
+}
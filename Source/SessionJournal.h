@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    SessionJournal.h
+    Created: 19 Oct 2026 3:47:09pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Dynamic1DWave.h"
+#include "DigitalWaveguide.h"
+#include "StabilityWatchdog.h"
+#include "Global.h"
+
+//==============================================================================
+/*
+    Records everything that goes into the simulation (the configuration from
+    prepareToPlay, wave speed changes at the sample where the audio thread picks
+    them up, excitations and the input in resonator mode) instead of its state.
+    The simulation is deterministic, so replay() renders the session again
+    sample by sample. A checksum of the output of every block is recorded as
+    well to verify that the replay is bit-exact.
+
+    The audio thread only pushes events into a lock-free FIFO; a background
+    thread writes them to the file. The input is recorded per block as float32
+    samples (in a FIFO of its own) that follow their inputBlock event in the
+    file, and blocks of silence are skipped.
+*/
+class SessionJournal : private Thread
+{
+public:
+    enum EventType : uint32
+    {
+        // configuration (at sample 0)
+        sampleRate = 0,
+        blockSize,
+        length,
+        initialWavespeed,
+        gridScaling,
+        theta,
+        idleDetection,
+        modalSynthesis,
+        useWaveguide,
+        outputRatio,
+        injectionRatio,
+        inputGain,
+        stabilityWatchdog,
+    
+        // inputs
+        wavespeed,
+        excite,
+        resonatorMode,
+        inputBlock, // value is the number of input samples (float32) that follow the event, starting at its sample
+        modalSwitch, // the grid switched to modes (when the background decomposition was done)
+    
+        outputChecksum // hash of the output (first channel) since the previous checksum
+    };
+    
+    struct Event
+    {
+        uint64 sampleIdx;
+        uint32 type;
+        uint32 reserved;
+        double value;
+    };
+    
+    SessionJournal (const std::string& fileName, int fifoSize = 1 << 15, int inputFifoSize = 1 << 17);
+    ~SessionJournal() override;
+    
+    bool startRecording(); // opens the file and starts the writer thread
+    void stopRecording();  // writes everything that is left and closes the file
+    
+    // audio thread
+    void record (uint64 sampleIdx, EventType type, double value);
+    void recordInput (uint64 startSampleIdx, const float* input, int numSamples); // skipped if all samples are zero
+    int getNumDroppedEvents() { return numDropped.load(); };
+    
+    // FNV-1a over the bits of the samples
+    static uint64 hashSamples (uint64 hash, const float* samples, int numSamples);
+    static const uint64 hashStart = 14695981039346656037ull;
+    static double hashToValue (uint64 hash) { double value; memcpy (&value, &hash, sizeof (double)); return value; };
+    
+    // Renders the session in journalFile (as fast as possible) and checks the output against the recorded checksums.
+    // The output is written to wavFile (32-bit float) unless it is empty. Returns true if the replay is bit-exact.
+    static bool replay (const std::string& journalFile, const std::string& wavFile);
+    
+private:
+    void run() override;
+    void writePending();
+    
+    // compares the rendered block with the recorded checksum and writes it (if there is a writer)
+    static bool checkBlock (std::vector<float>& block, const Event& checksum, AudioFormatWriter* writer, int& numMismatches);
+    
+    static const uint32 journalMagic = 0x4a474449; // "IDGJ"
+    static const uint32 journalVersion = 4;
+    
+    std::string fileName;
+    std::ofstream journal;
+    
+    AbstractFifo fifo;
+    std::vector<Event> fifoBuffer;
+    
+    // the samples of the inputBlock events in the event FIFO (always pushed before their event)
+    AbstractFifo inputFifo;
+    std::vector<float> inputFifoBuffer;
+    std::atomic<int> numDropped { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SessionJournal)
+};
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    StabilityWatchdog.cpp
+    Created: 19 Oct 2026 10:26:51am
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "StabilityWatchdog.h"
+
+StabilityWatchdog::StabilityWatchdog (double windowSeconds, double maxGrowth) : windowSeconds (windowSeconds), maxGrowth (maxGrowth)
+{
+    prepare (44100, 512);
+}
+
+void StabilityWatchdog::prepare (double fs, int blockSize)
+{
+    energies.resize (std::max (2, static_cast<int> (ceil (windowSeconds * fs / std::max (1, blockSize)))), 0);
+    writeIdx = 0;
+    numConsecutiveDamped = 0;
+    prevWavespeed = 0;
+    notifyExcitation();
+}
+
+StabilityWatchdog::Action StabilityWatchdog::check (Dynamic1DWave& wave)
+{
+    // The energy of the modes would have to be reconstructed on the grid (O(N * modes)), but modes can't grow
+    // (ModalEngine::project() leaves those out), so while they are active only their finiteness is checked.
+    const bool modalActive = wave.isModalActive();
+    
+    // NaN and inf propagate through the sum
+    const double energy = modalActive ? 0.0 : wave.getEnergy();
+    const double injected = wave.takeInjectedEnergy();
+    if (!std::isfinite (wave.getStateSumOfSquares()) || !std::isfinite (energy))
+    {
+        wave.resetState();
+        notifyExcitation();
+        numConsecutiveDamped = 0;
+        ++numResets;
+        return reset;
+    }
+    
+    // the window starts over when the grid takes over again
+    if (modalActive)
+    {
+        notifyExcitation();
+        numConsecutiveDamped = 0;
+        prevWavespeed = wave.getWavespeed();
+        return none;
+    }
+    
+    const double c = wave.getWavespeed();
+    if (std::abs (c - prevWavespeed) > maxWavespeedChange * prevWavespeed)
+        notifyExcitation();
+    prevWavespeed = c;
+    
+    injectedEnergy += injected / c;
+    const double intrinsicEnergy = energy / c - injectedEnergy;
+    
+    int size = static_cast<int> (energies.size());
+    if (numEnergies > 0)
+    {
+        // oldest energy in the window (growing faster than that is only more suspicious)
+        double energyStart = energies[(writeIdx - numEnergies + size) % size];
+        if (intrinsicEnergy > energyFloor && intrinsicEnergy > maxGrowth * std::max (energyStart, energyFloor))
+        {
+            // damping did not help
+            if (++numConsecutiveDamped > maxConsecutiveDamped)
+            {
+                wave.resetState();
+                notifyExcitation();
+                numConsecutiveDamped = 0;
+                ++numResets;
+                return reset;
+            }
+            
+            // back to the energy at the start of the window (plus what was injected since), which stays the reference
+            wave.scaleState (sqrt (std::max (c * (energyStart + injectedEnergy), 0.0) / energy));
+            energies[0] = energyStart;
+            writeIdx = 1 % size;
+            numEnergies = 1;
+            ++numDamped;
+            return damped;
+        }
+    }
+    numConsecutiveDamped = 0;
+    
+    energies[writeIdx] = intrinsicEnergy;
+    writeIdx = (writeIdx + 1) % size;
+    numEnergies = std::min (numEnergies + 1, size);
+    return none;
+}
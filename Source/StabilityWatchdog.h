@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    StabilityWatchdog.h
+    Created: 19 Oct 2026 10:26:51am
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Dynamic1DWave.h"
+
+//==============================================================================
+/*
+    Checks a string once per block (on the audio thread) and recovers it when
+    the scheme goes unstable:
+    - if any of the states is not finite, the string is reset to rest,
+    - if the energy grows by more than maxGrowth within windowSeconds, the
+      states are scaled back to the energy at the start of the window (and
+      reset if that does not help).
+    The energy that a healthy string gains or loses on purpose doesn't count:
+    it is divided by c (E / f is constant while c changes slowly), the energy
+    injected by forces is subtracted and the window starts over after an
+    excitation or a block in which c changed by more than maxWavespeedChange
+    (adding and removing points quickly moves energy in and out). Both checks
+    are O(N) once per block. While the string is in its modes (which can't
+    grow) only their finiteness is checked, which is O(modes). The number of
+    recoveries is published through atomics so that they can be reported from
+    the message thread.
+*/
+class StabilityWatchdog
+{
+public:
+    enum Action
+    {
+        none = 0,
+        damped,
+        reset
+    };
+    
+    StabilityWatchdog (double windowSeconds = 0.25, double maxGrowth = 10.0);
+    
+    // sizes the window for this sample rate and block size and starts over (not while check() can be called)
+    void prepare (double fs, int blockSize);
+    
+    // audio thread (after every block)
+    Action check (Dynamic1DWave& wave);
+    void notifyExcitation() { numEnergies = 0; injectedEnergy = 0; }; // energy is added on purpose, so the growth starts over
+    
+    int getNumResets() { return numResets.load(); };
+    int getNumDamped() { return numDamped.load(); };
+    
+private:
+    double windowSeconds, maxGrowth;
+    double energyFloor = 1e-6; // below this (divided by c), growth is not considered
+    double maxWavespeedChange = 0.01; // relative change of c within a block above which the window starts over
+    double prevWavespeed = 0;
+    double injectedEnergy = 0; // by forces since the window started, divided by c
+    int numConsecutiveDamped = 0;
+    int maxConsecutiveDamped = 4; // the string is reset if it keeps growing after this many blocks of damping
+    
+    // energy / c (minus injectedEnergy at that time) after each of the last energies.size() blocks
+    std::vector<double> energies;
+    int writeIdx = 0;
+    int numEnergies = 0;
+    
+    std::atomic<int> numResets { 0 };
+    std::atomic<int> numDamped { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StabilityWatchdog)
+};
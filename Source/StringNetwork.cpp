@@ -0,0 +1,284 @@
+/*
+  ==============================================================================
+
+    StringNetwork.cpp
+    Created: 19 Oct 2026 4:48:03pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "StringNetwork.h"
+
+StringNetwork::StringNetwork (double k) : k (k)
+{
+}
+
+int StringNetwork::addString (NamedValueSet& parameters)
+{
+    strings.push_back (std::make_unique<Dynamic1DWave> (parameters, k));
+    int idx = static_cast<int> (strings.size()) - 1;
+    
+    // the string's own displacement correction becomes part of the network
+    strings[idx]->setExternalJunctionCorrection (true);
+    
+    Connection junction;
+    junction.a = { idx, 0, -1, 1, 0 };
+    junction.b = { idx, 0, -1, 1, 0 };
+    junction.invAlpha = 0;
+    junction.betaOverAlpha = 0;
+    junction.isJunction = true;
+    addConnection (junction);
+    
+    return idx;
+}
+
+void StringNetwork::addConnection (int stringA, double ratioA, int stringB, double ratioB, double stiffness, double damping)
+{
+    jassert (stiffness > 0 || damping > 0);
+    
+    double alpha = stiffness * 0.5 + damping / (2.0 * k);
+    double beta = stiffness * 0.5 - damping / (2.0 * k);
+    
+    Connection connection;
+    connection.a = { stringA, ratioA, -1, 0, 0 };
+    connection.b = { stringB, ratioB, -1, 0, 0 };
+    connection.invAlpha = 1.0 / alpha;
+    connection.betaOverAlpha = beta / alpha;
+    connection.isJunction = false;
+    addConnection (connection);
+    
+    // forces act on the grid, so the connected strings can't switch to modes
+    strings[stringA]->setModalSynthesis (false);
+    strings[stringB]->setModalSynthesis (false);
+}
+
+void StringNetwork::addConnection (const Connection& connection)
+{
+    connections.push_back (connection);
+    
+    // allocate everything here so that nothing needs to be allocated while running
+    int numConnections = static_cast<int> (connections.size());
+    parent.resize (numConnections);
+    order.resize (numConnections);
+    clusterStart.resize (numConnections + 1);
+    matrix.resize (numConnections * numConnections);
+    rhs.resize (numConnections);
+    force.resize (numConnections);
+    
+    clustersValid = false;
+}
+
+void StringNetwork::calculate()
+{
+    for (auto& string : strings)
+    {
+        string->updateParams();
+        string->calculate();
+    }
+    
+    if (connections.empty())
+        return;
+    
+    updateConnectionPoints();
+    if (!clustersValid)
+        findClusters();
+    
+    // right hand side: eta^{n+1} without the connection forces and eta^{n-1}
+    for (size_t i = 0; i < connections.size(); ++i)
+    {
+        Connection& con = connections[i];
+        if (con.isJunction)
+        {
+            int idxU = strings[con.a.string]->getJunctionIndex();
+            double etaNext = strings[con.a.string]->getState (idxU + 1, 0) - strings[con.a.string]->getState (idxU, 0);
+            double etaPrev = strings[con.a.string]->getState (idxU + 1, 2) - strings[con.a.string]->getState (idxU, 2);
+            strings[con.a.string]->getJunctionCoefficients (con.invAlpha, con.betaOverAlpha);
+            rhs[i] = etaNext + con.betaOverAlpha * etaPrev;
+            continue;
+        }
+        
+        double etaNext = strings[con.a.string]->getStateAt (con.a.ratio, 0) - strings[con.b.string]->getStateAt (con.b.ratio, 0);
+        double etaPrev = strings[con.a.string]->getStateAt (con.a.ratio, 2) - strings[con.b.string]->getStateAt (con.b.ratio, 2);
+        rhs[i] = etaNext + con.betaOverAlpha * etaPrev;
+    }
+    
+    for (size_t c = 0; c + 1 < clusterStart.size() && clusterStart[c] < static_cast<int> (connections.size()); ++c)
+        solveCluster (clusterStart[c], clusterStart[c+1] - clusterStart[c]);
+    
+    // the force pulls string a towards b and vice versa
+    for (size_t i = 0; i < connections.size(); ++i)
+    {
+        Connection& con = connections[i];
+        if (con.isJunction)
+        {
+            int idxU = strings[con.a.string]->getJunctionIndex();
+            strings[con.a.string]->getState (idxU + 1, 0) -= strings[con.a.string]->getForceScaling() * force[i];
+            strings[con.a.string]->getState (idxU, 0) += strings[con.a.string]->getForceScaling() * force[i];
+            continue;
+        }
+        strings[con.a.string]->addForceAt (con.a.ratio, -force[i]);
+        strings[con.b.string]->addForceAt (con.b.ratio, force[i]);
+    }
+}
+
+void StringNetwork::updateStates()
+{
+    for (auto& string : strings)
+        string->updateStates();
+}
+
+double StringNetwork::getOutput (double ratio)
+{
+    double output = 0;
+    for (auto& string : strings)
+        output += string->getOutput (ratio);
+    return output;
+}
+
+void StringNetwork::updateConnectionPoints()
+{
+    for (auto& con : connections)
+    {
+        if (con.isJunction)
+        {
+            int prevIdx = con.b.idx;
+            con.b.idx = strings[con.a.string]->getJunctionIndex(); // u_M
+            con.a.idx = con.b.idx + 1;                              // w_0
+            if (con.b.idx != prevIdx)
+                clustersValid = false;
+            continue;
+        }
+        
+        for (ConnectionPoint* point : { &con.a, &con.b })
+        {
+            int prevIdx = point->idx;
+            strings[point->string]->getConnectionPoints (point->ratio, point->idx, point->weight0, point->weight1);
+            
+            // the grid changed, so connections might (not) overlap anymore
+            if (point->idx != prevIdx)
+                clustersValid = false;
+        }
+    }
+}
+
+int StringNetwork::findRoot (int i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void StringNetwork::findClusters()
+{
+    int numConnections = static_cast<int> (connections.size());
+    for (int i = 0; i < numConnections; ++i)
+        parent[i] = i;
+    
+    // connections are in the same cluster if they share a point on a string
+    for (int i = 0; i < numConnections; ++i)
+        for (int j = i + 1; j < numConnections; ++j)
+            if (calculateCoupling (i, j) != 0)
+                parent[findRoot (i)] = findRoot (j);
+    
+    // counting sort by root
+    int numClusters = 0;
+    int idx = 0;
+    for (int root = 0; root < numConnections; ++root)
+    {
+        if (findRoot (root) != root)
+            continue;
+        clusterStart[numClusters++] = idx;
+        for (int i = 0; i < numConnections; ++i)
+            if (findRoot (i) == root)
+                order[idx++] = i;
+    }
+    for (int c = numClusters; c <= numConnections; ++c)
+        clusterStart[c] = numConnections;
+    
+    clustersValid = true;
+}
+
+double StringNetwork::calculateOverlap (const ConnectionPoint& p1, const ConnectionPoint& p2)
+{
+    if (p1.string != p2.string || std::abs (p1.idx - p2.idx) > 1)
+        return 0;
+    
+    double w1[2] = { p1.weight0, p1.weight1 };
+    double w2[2] = { p2.weight0, p2.weight1 };
+    double overlap = 0;
+    for (int m = 0; m < 2; ++m)
+        for (int n = 0; n < 2; ++n)
+            if (p1.idx + m == p2.idx + n)
+                overlap += w1[m] * w2[n];
+    
+    return overlap * strings[p1.string]->getForceScaling();
+}
+
+double StringNetwork::calculateCoupling (int i, int j)
+{
+    const Connection& ci = connections[i];
+    const Connection& cj = connections[j];
+    
+    // eta = a - b, and connection j pushes a down and b up
+    return calculateOverlap (ci.a, cj.a) - calculateOverlap (ci.a, cj.b)
+         - calculateOverlap (ci.b, cj.a) + calculateOverlap (ci.b, cj.b);
+}
+
+void StringNetwork::solveCluster (int start, int size)
+{
+    // solves (diag (1 / alpha) + G) F = rhs
+    if (size == 1)
+    {
+        int i = order[start];
+        force[i] = rhs[i] / (connections[i].invAlpha + calculateCoupling (i, i));
+        return;
+    }
+    
+    double* A = &matrix[0];
+    for (int r = 0; r < size; ++r)
+    {
+        for (int c = 0; c <= r; ++c)
+            A[r * size + c] = calculateCoupling (order[start + r], order[start + c]);
+        A[r * size + r] += connections[order[start + r]].invAlpha;
+    }
+    
+    // Cholesky decomposition (lower triangle, in place). The matrix is symmetric positive definite.
+    for (int c = 0; c < size; ++c)
+    {
+        double diag = A[c * size + c];
+        for (int m = 0; m < c; ++m)
+            diag -= A[c * size + m] * A[c * size + m];
+        diag = sqrt (diag);
+        A[c * size + c] = diag;
+        
+        for (int r = c + 1; r < size; ++r)
+        {
+            double val = A[r * size + c];
+            for (int m = 0; m < c; ++m)
+                val -= A[r * size + m] * A[c * size + m];
+            A[r * size + c] = val / diag;
+        }
+    }
+    
+    // forward substitution
+    for (int r = 0; r < size; ++r)
+    {
+        double val = rhs[order[start + r]];
+        for (int m = 0; m < r; ++m)
+            val -= A[r * size + m] * force[order[start + m]];
+        force[order[start + r]] = val / A[r * size + r];
+    }
+    
+    // backward substitution
+    for (int r = size - 1; r >= 0; --r)
+    {
+        double val = force[order[start + r]];
+        for (int m = r + 1; m < size; ++m)
+            val -= A[m * size + r] * force[order[start + m]];
+        force[order[start + r]] = val / A[r * size + r];
+    }
+}
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    StringNetwork.h
+    Created: 19 Oct 2026 4:48:03pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Dynamic1DWave.h"
+
+//==============================================================================
+/*
+    A network of dynamic strings joined at arbitrary points by damped springs
+    (the generalisation of displacementCorrection). All connection forces,
+    including the displacement corrections at the inner boundaries of the
+    strings themselves, are solved together every sample. Connections only interact when they act on
+    (neighbouring) points of the same string, so the system is split into
+    independent clusters that are solved with a small Cholesky decomposition each.
+*/
+class StringNetwork
+{
+public:
+    StringNetwork (double k);
+    
+    int addString (NamedValueSet& parameters); // returns the index of the string
+    void addConnection (int stringA, double ratioA, int stringB, double ratioB, double stiffness, double damping);
+    
+    Dynamic1DWave& getString (int idx) { return *strings[idx]; };
+    int getNumStrings() { return static_cast<int> (strings.size()); };
+    
+    void calculate();
+    void updateStates();
+    
+    double getOutput (double ratio); // sum of the outputs of all strings
+    
+private:
+    struct ConnectionPoint
+    {
+        int string;
+        double ratio;
+        int idx;
+        double weight0, weight1;
+    };
+    
+    struct Connection
+    {
+        ConnectionPoint a, b;
+        double invAlpha, betaOverAlpha; // F = alpha * eta^{n+1} + beta * eta^{n-1}
+        bool isJunction; // the connection between w_0 (a) and u_M (b) of string a.string
+    };
+    
+    void addConnection (const Connection& connection);
+    
+    void updateConnectionPoints(); // invalidates the clusters if any of the points moved to a different grid index
+    void findClusters();
+    double calculateOverlap (const ConnectionPoint& p1, const ConnectionPoint& p2); // sum of the products of the interpolation weights
+    double calculateCoupling (int i, int j); // element of G: the change in eta_i due to a unit force of connection j
+    void solveCluster (int start, int size);
+    
+    int findRoot (int i);
+    
+    double k;
+    std::vector<std::unique_ptr<Dynamic1DWave>> strings;
+    std::vector<Connection> connections;
+    
+    bool clustersValid = false;
+    std::vector<int> parent;         // union-find
+    std::vector<int> order;          // connections sorted by cluster
+    std::vector<int> clusterStart;   // offsets into order (with one extra entry at the end)
+    
+    std::vector<double> matrix;      // scratch space for the dense matrix of one cluster
+    std::vector<double> rhs, force;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StringNetwork)
+};
@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    VibratingString.h
+    Created: 19 Oct 2026 3:12:54pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/*
+    What the audio callback (and a replay) needs from a string, so that the
+    grid (Dynamic1DWave) and the waveguide (DigitalWaveguide) can be swapped.
+    Per sample: changeWavespeed(), updateParams(), calculate(), updateStates()
+    and getOutput(). Forces and connections only exist on the grid.
+*/
+class VibratingString
+{
+public:
+    virtual ~VibratingString() = default;
+
+    virtual void calculate() = 0;
+    virtual void updateStates() = 0;
+    virtual double getOutput (double ratio) = 0; // displacement at ratio * L
+
+    virtual void excite() = 0; // adds a raised cosine at 0.2 L
+
+    virtual void changeWavespeed (double val) = 0; // c is only used once per sample (before everything else)
+    virtual void updateParams() = 0;
+    virtual double getWavespeed() = 0;
+    virtual double getLength() = 0;
+
+    virtual double getEnergy() = 0; // discrete energy of the current state
+};